@@ -0,0 +1,306 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "lexan.hpp"
+#include "runindex.hpp"
+#include "runs.hpp"
+#include "histogram.hpp"
+#include "dfa.hpp"
+#include "oddruns_dfa.hpp"
+#include "pairs_dfa.hpp"
+#include "stride.hpp"
+#include "speculative.hpp"
+#include "bitmatch.hpp"
+#include "dfajit.hpp"
+
+/// Секундомер для замеров.
+struct Stopwatch
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+/// Случайная битовая строка из серий длиной 1..maxRun.
+std::string generateBits(size_t n, size_t maxRun = 8, unsigned seed = 42)
+{
+    std::mt19937 rng(seed);
+    std::string bits;
+    char c = '0';
+    while (bits.size() < n)
+    {
+        bits.append(1 + rng() % maxRun, c);
+        c = c == '0' ? '1' : '0';
+    }
+    bits.resize(n);
+    return bits;
+}
+
+/// Строка из серий длины 1 или 3: автомат oddRuns читает её, не попадая в dead.
+std::string generateOddRuns(size_t n, unsigned seed = 7)
+{
+    std::mt19937 rng(seed);
+    std::string bits;
+    for (char c = '0'; bits.size() < n; c = c == '0' ? '1' : '0')
+        bits.append(rng() % 2 ? 3 : 1, c);
+    return bits;
+}
+
+/// Запросы к подстрокам: индекс против повторного сканирования.
+void benchRunIndex()
+{
+    std::cout << "=== Индекс подстрок ===\n";
+    std::string bits = generateBits(100000000);
+    Stopwatch build;
+    OddRunIndex index(bits);
+    std::cout << "Построение индекса для " << bits.size() / 1000000 << " млн бит: " << build.seconds() << " с\n";
+
+    std::mt19937 rng(1);
+    const size_t queries = 1000000, length = 100000;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (size_t q = 0; q < queries; ++q)
+    {
+        size_t l = rng() % (bits.size() - length);
+        ranges.push_back({l, l + 1 + rng() % length});
+    }
+
+    size_t yes = 0;
+    Stopwatch indexed;
+    for (auto [l, r] : ranges)
+        yes += index.query(l, r);
+    double t = indexed.seconds();
+    std::cout << "Индекс: " << queries / t / 1e6 << " млн запросов/с (истинно " << yes << ")\n";
+
+    const size_t scans = 2000;
+    Stopwatch scanned;
+    for (size_t q = 0; q < scans; ++q)
+        yes += dfaOddConsecutive(bits.substr(ranges[q].first, ranges[q].second - ranges[q].first));
+    std::cout << "Сканирование подстроки: " << scans / scanned.seconds() / 1e6 << " млн запросов/с\n\n";
+}
+
+/// Поиск нечётных серий с буферизованным выводом позиций.
+void benchOddRuns()
+{
+    std::cout << "=== Позиции нечётных серий ===\n";
+    for (size_t maxRun : {8, 64, 1024})
+    {
+        std::string bits = generateBits(256 << 20, maxRun);
+        std::FILE *sink = std::fopen("/dev/null", "w");
+        size_t found = 0;
+        Stopwatch timer;
+        {
+            RunWriter writer(sink);
+            reportOddRuns(bits, [&](const Run &run)
+                          { found++; writer(run); });
+        }
+        double t = timer.seconds();
+        std::fclose(sink);
+        std::cout << "Серии до " << maxRun << ": " << bits.size() / t / 1e9 << " ГБ/с, найдено " << found << "\n";
+    }
+    std::cout << "\n";
+}
+
+/// Гистограмма длин серий по числу потоков.
+void benchHistogram()
+{
+    std::cout << "=== Гистограмма серий ===\n";
+    std::string bits = generateBits(256 << 20, 64);
+    for (size_t threads : {1, 2, 4})
+    {
+        Stopwatch timer;
+        RunHistogram histogram = runHistogram(bits.data(), bits.size(), threads);
+        double t = timer.seconds();
+        std::cout << "Потоков " << threads << ": " << bits.size() / t / 1e9 << " ГБ/с, серий длины 1: "
+                  << histogram.exact[0][1] + histogram.exact[1][1] << "\n";
+    }
+    std::cout << "Ядер: " << std::thread::hardware_concurrency() << "\n\n";
+}
+
+/**
+ * Скорость распознавателя в ГБ/с на строке bits (четыре прохода).
+ * Пустая ассемблерная вставка после каждого прохода «использует» результат и
+ * сообщает компилятору, что строка могла измениться, поэтому вызов нельзя
+ * ни выбросить, ни вынести из цикла.
+ */
+template <typename Recognise>
+std::pair<double, bool> measureRecogniser(const std::string &bits, Recognise &&recognise)
+{
+    bool result = false;
+    Stopwatch timer;
+    for (int r = 0; r < 4; ++r)
+    {
+        result ^= recognise();
+        __asm__ volatile("" : : "r"(result), "r"(bits.data()) : "memory");
+    }
+    return {bits.size() * 4 / timer.seconds() / 1e9, result};
+}
+
+/// Прямой код против табличного распознавателя для одного автомата.
+void benchDfaEngines(const char *name, const char *spec, bool (*direct)(const char *, size_t), const std::string &bits)
+{
+    DfaTable table(Dfa::parse(spec));
+    auto [directSpeed, directResult] = measureRecogniser(bits, [&]
+                                                         { return direct(bits.data(), bits.size()); });
+    auto [tableSpeed, tableResult] = measureRecogniser(bits, [&]
+                                                       { return table.accepts(bits.data(), bits.size()); });
+    std::cout << name << ": прямой код " << directSpeed << " ГБ/с, таблица " << tableSpeed << " ГБ/с"
+              << (directResult == tableResult ? "" : " (РАСХОЖДЕНИЕ)") << ", быстрее — "
+              << (directSpeed > tableSpeed ? "прямой код" : "таблица") << "\n";
+}
+
+/// Способы исполнения автоматов из описаний; для сравнения — dfaOddConsecutive на тех же данных.
+void benchDfa()
+{
+    std::cout << "=== Прямой код и таблицы переходов ===\n";
+    // На pairs — те же серии удвоенной длины: оба автомата читают вход до конца
+    std::string odd = generateOddRuns(128 << 20), pairs;
+    for (char c : odd)
+        pairs.append(2, c);
+
+    // Вызов через volatile-указатель: иначе встроенная функция выносится из цикла замера
+    bool (*volatile counter)(const std::string &) = dfaOddConsecutive;
+    std::cout << "dfaOddConsecutive: " << measureRecogniser(odd, [&]
+                                                            { return counter(odd); })
+                                              .first
+              << " ГБ/с\n";
+    benchDfaEngines("oddRuns", oddRunsSpec, oddRunsDirect, odd);
+    benchDfaEngines("pairs", pairsSpec, pairsDirect, pairs);
+    std::cout << "\n";
+}
+
+/// Таблицы с многобайтовым шагом: явный шаг и автоматический выбор под L1 и L2.
+void benchStride()
+{
+    std::cout << "=== Многобайтовый шаг ===\n";
+    std::string bits = generateOddRuns(128 << 20);
+    Dfa dfa = Dfa::parse(oddRunsSpec);
+    DfaTable table(dfa);
+    std::cout << "Побайтовая таблица: " << measureRecogniser(bits, [&]
+                                                             { return table.accepts(bits.data(), bits.size()); })
+                                               .first
+              << " ГБ/с\n";
+    auto report = [&](const char *label, const StrideDfa &engine)
+    {
+        std::cout << label << "шаг " << engine.step() << " (таблица " << engine.tableBytes() << " Б): "
+                  << measureRecogniser(bits, [&]
+                                       { return engine.accepts(bits.data(), bits.size()); })
+                         .first
+                  << " ГБ/с\n";
+    };
+    for (size_t stride : {1, 2, 4, 8})
+        report("", StrideDfa(dfa, stride));
+    report("Авто под L1: ", StrideDfa(dfa, 0, StrideDfa::L1));
+    report("Авто под L2: ", StrideDfa(dfa, 0, StrideDfa::L2));
+    std::cout << "\n";
+}
+
+/// Спекулятивный параллельный запуск автомата oddRuns против последовательного.
+void benchSpeculative()
+{
+    std::cout << "=== Спекулятивный параллельный автомат ===\n";
+    Dfa dfa = Dfa::parse(oddRunsSpec);
+    StrideDfa sequential(dfa);
+    // Допускаемый поток (автомат всё время жив) и случайный (быстро попадает в dead)
+    std::pair<const char *, std::string> inputs[] = {{"серии 1 и 3", generateOddRuns(256 << 20)},
+                                                     {"случайные серии", generateBits(256 << 20)}};
+    for (const auto &[label, bits] : inputs)
+    {
+        SpeculativeDfa speculative(dfa);
+        speculative.learn(bits.data(), 1 << 20);
+        double base = measureRecogniser(bits, [&]
+                                        { return sequential.accepts(bits.data(), bits.size()); })
+                          .first;
+        std::cout << label << ": последовательно " << base << " ГБ/с\n";
+        for (size_t threads : {1, 2, 4})
+        {
+            SpeculationStats stats;
+            double speed = measureRecogniser(bits, [&]
+                                             { return speculative.accepts(speculative.run(bits.data(), bits.size(), threads, &stats)); })
+                               .first;
+            std::cout << "  потоков " << threads << ": " << speed << " ГБ/с (x" << speed / base << "), частей "
+                      << stats.chunks << ", не угадано " << stats.mispredicted << ", перечитано " << stats.rescanned << " Б\n";
+        }
+    }
+    std::cout << "Ядер: " << std::thread::hardware_concurrency() << "\n\n";
+}
+
+/// Поиск запрещённых подцепочек: Shift-Or по упакованной строке против std::string::find.
+void benchBitMatch()
+{
+    std::cout << "=== Поиск образцов в упакованной строке ===\n";
+    std::string bits = generateBits(64 << 20, 6);
+    Stopwatch packing;
+    PackedBits text(bits);
+    std::cout << "Упаковка: " << bits.size() / packing.seconds() / 1e9 << " ГБ/с\n";
+
+    std::mt19937 rng(3);
+    std::vector<std::string> many = {"0110"};
+    while (many.size() < 16)
+    {
+        std::string pattern;
+        for (size_t i = 0, length = 12 + rng() % 20; i < length; ++i)
+            pattern += "01"[rng() % 2];
+        many.push_back(pattern);
+    }
+    for (size_t count : {size_t(1), many.size()})
+    {
+        std::vector<std::string> patterns(many.begin(), many.begin() + count);
+        size_t expected = 0, found = 0;
+        Stopwatch naive;
+        for (const std::string &pattern : patterns)
+            for (size_t pos = bits.find(pattern); pos != std::string::npos; pos = bits.find(pattern, pos + 1))
+                expected++;
+        double naiveTime = naive.seconds();
+        BitPatternMatcher matcher(patterns);
+        Stopwatch parallel;
+        matcher.find(text, [&](size_t, size_t)
+                     { found++; });
+        double parallelTime = parallel.seconds();
+        std::cout << "Образцов " << count << ": find " << bits.size() / naiveTime / 1e9 << " ГБ/с, Shift-Or "
+                  << bits.size() / parallelTime / 1e9 << " ГБ/с, вхождений " << found
+                  << (found == expected ? "" : " (РАСХОЖДЕНИЕ)") << "\n";
+    }
+    std::cout << "\n";
+}
+
+/// JIT автомата против табличного распознавателя: автомат lab1 и большой случайный.
+void benchDfaJit()
+{
+    std::cout << "=== JIT автоматов ===\n";
+    std::mt19937 rng(11);
+    std::string letters;
+    for (size_t i = 0; i < (64 << 20); ++i)
+        letters += "abcdefghijklmnop"[rng() % 16];
+    std::tuple<const char *, Dfa, std::string> cases[] = {
+        {"oddRuns", Dfa::parse(oddRunsSpec), generateOddRuns(128 << 20)},
+        {"случайный, 1000 состояний", randomDfa(1000, "abcdefghijklmnop"), letters}};
+    for (const auto &[label, dfa, input] : cases)
+    {
+        DfaTable table(dfa);
+        JitDfa jit(dfa);
+        auto [tableSpeed, tableResult] = measureRecogniser(input, [&]
+                                                           { return table.accepts(input.data(), input.size()); });
+        auto [jitSpeed, jitResult] = measureRecogniser(input, [&]
+                                                       { return jit.accepts(input.data(), input.size()); });
+        std::cout << label << ": таблица " << tableSpeed << " ГБ/с, JIT " << jitSpeed << " ГБ/с (код "
+                  << jit.codeBytes() << " Б" << (jit.native() ? "" : ", нет JIT") << ")"
+                  << (tableResult == jitResult ? "" : " (РАСХОЖДЕНИЕ)") << "\n";
+    }
+    std::cout << "\n";
+}
+
+int main()
+{
+    benchRunIndex();
+    benchOddRuns();
+    benchHistogram();
+    benchDfa();
+    benchStride();
+    benchSpeculative();
+    benchBitMatch();
+    benchDfaJit();
+    return 0;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Битовая строка, упакованная по 64 символа в слово: бит i равен 1, если str[i] == '1'.
+ * Символы, отличные от '0' и '1', упаковываются как 0 и отмечаются флагом valid().
+ */
+class PackedBits
+{
+    std::vector<std::uint64_t> words;
+    size_t length = 0;
+    bool onlyBits = true;
+
+public:
+    explicit PackedBits(const std::string &str) : words(str.size() / 64 + 1, 0), length(str.size())
+    {
+        const char *data = str.data();
+        size_t i = 0;
+#if defined(__SSE2__)
+        // 16 символов за раз: маска единиц и маска недопустимых символов через movemask
+        const __m128i one = _mm_set1_epi8('1'), zero = _mm_set1_epi8('0');
+        unsigned bad = 0;
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            unsigned ones = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, one));
+            unsigned zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero));
+            bad |= ~(ones | zeros) & 0xFFFF;
+            words[i / 64] |= std::uint64_t(ones) << (i % 64);
+        }
+        onlyBits = bad == 0;
+#endif
+        for (; i < length; ++i)
+        {
+            if (data[i] == '1')
+                words[i / 64] |= std::uint64_t(1) << (i % 64);
+            else if (data[i] != '0')
+                onlyBits = false;
+        }
+    }
+
+    size_t size() const { return length; }
+    bool valid() const { return onlyBits; }
+
+    /// Слово с битами [64 * i, 64 * i + 64); за концом строки — нули.
+    std::uint64_t word(size_t i) const { return i < words.size() ? words[i] : 0; }
+};
+
+/**
+ * Поиск нескольких битовых образцов (длиной до 64) в упакованной строке,
+ * по 64 позиции начала за раз (Shift-Or по позициям текста).
+ *
+ * Для слова текста w и сдвига k окно (слово, начинающееся с бита 64w + k)
+ * сравнивается с k-м символом образца; OR несовпадений по всем k даёт маску
+ * позиций, где образец не встречается. Образцы хранятся в боре по битам,
+ * поэтому общие префиксы сравниваются один раз, а поддерево отбрасывается,
+ * как только все 64 позиции уже не совпали.
+ */
+class BitPatternMatcher
+{
+    struct Node
+    {
+        int child[2] = {-1, -1};
+        std::vector<size_t> patterns; // Образцы, заканчивающиеся в этой вершине
+    };
+    std::vector<Node> trie{1};
+    std::vector<size_t> lengths;
+
+    template <typename Callback>
+    void descend(int node, size_t depth, std::uint64_t mismatch, std::uint64_t lo, std::uint64_t hi,
+                 size_t base, size_t n, Callback &onMatch) const
+    {
+        for (size_t pattern : trie[node].patterns)
+        {
+            // Позиции, где образец целиком помещается в строку
+            std::uint64_t found = ~mismatch;
+            if (base + 64 + lengths[pattern] > n)
+                found &= n >= base + lengths[pattern] ? ~std::uint64_t(0) >> (63 - (n - base - lengths[pattern])) : 0;
+            for (; found; found &= found - 1)
+                onMatch(pattern, base + __builtin_ctzll(found));
+        }
+        if (depth == 64)
+            return;
+        std::uint64_t window = depth == 0 ? lo : (lo >> depth) | (hi << (64 - depth));
+        for (int bit = 0; bit < 2; ++bit)
+        {
+            int next = trie[node].child[bit];
+            if (next == -1)
+                continue;
+            std::uint64_t m = mismatch | (bit ? ~window : window);
+            if (~m)
+                descend(next, depth + 1, m, lo, hi, base, n, onMatch);
+        }
+    }
+
+public:
+    /**
+     * @param patterns Образцы из символов '0' и '1' длиной от 1 до 64.
+     * @throws std::invalid_argument для пустого, слишком длинного или недвоичного образца.
+     */
+    explicit BitPatternMatcher(const std::vector<std::string> &patterns)
+    {
+        for (const std::string &pattern : patterns)
+        {
+            if (pattern.empty() || pattern.size() > 64 || pattern.find_first_not_of("01") != std::string::npos)
+                throw std::invalid_argument("образец должен состоять из 1..64 символов '0' и '1': " + pattern);
+            int node = 0;
+            for (char c : pattern)
+            {
+                int bit = c - '0';
+                if (trie[node].child[bit] == -1)
+                {
+                    trie[node].child[bit] = static_cast<int>(trie.size());
+                    trie.emplace_back();
+                }
+                node = trie[node].child[bit];
+            }
+            trie[node].patterns.push_back(lengths.size());
+            lengths.push_back(pattern.size());
+        }
+    }
+
+    /**
+     * Сообщает о всех вхождениях: onMatch(номер образца, позиция начала),
+     * по возрастанию позиций в пределах каждого слова.
+     * Недопустимые символы строки считаются нулями — проверяйте text.valid().
+     */
+    template <typename Callback>
+    void find(const PackedBits &text, Callback &&onMatch) const
+    {
+        size_t n = text.size();
+        for (size_t w = 0; w * 64 < n; ++w)
+            descend(0, 0, 0, text.word(w), text.word(w + 1), w * 64, n, onMatch);
+    }
+
+    /// Встречается ли хотя бы один образец (поиск останавливается на первом слове с вхождением).
+    bool containsAny(const PackedBits &text) const
+    {
+        bool found = false;
+        auto mark = [&](size_t, size_t)
+        { found = true; };
+        size_t n = text.size();
+        for (size_t w = 0; w * 64 < n && !found; ++w)
+            descend(0, 0, 0, text.word(w), text.word(w + 1), w * 64, n, mark);
+        return found;
+    }
+};
+
+/**
+ * Проверяет, что строка из '0' и '1' не содержит ни одной запрещённой подцепочки
+ * (например, "0110"). Дополняет dfaOddConsecutive для проверок вида
+ * «запрещённая подстрока» вместо чётности серий.
+ *
+ * @param str       Входная строка.
+ * @param forbidden Запрещённые подцепочки длиной 1..64.
+ * @return true, если строка двоичная и не содержит ни одной запрещённой подцепочки.
+ */
+bool bitsAvoid(const std::string &str, const std::vector<std::string> &forbidden)
+{
+    PackedBits text(str);
+    return text.valid() && !BitPatternMatcher(forbidden).containsAny(text);
+}
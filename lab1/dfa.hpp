@@ -0,0 +1,196 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Детерминированный конечный автомат над байтами, заданный описанием.
+ *
+ * Текстовый формат описания (по одной директиве в строке, '#' — комментарий):
+ *   name <имя>                        — имя автомата для генератора кода
+ *   start <состояние>                 — начальное состояние
+ *   accept <состояние> ...            — принимающие состояния
+ *   <состояние> <символ> <состояние>  — переход
+ * Переходы, не заданные явно, ведут в тупиковое состояние dead,
+ * которое добавляется последним.
+ */
+struct Dfa
+{
+    std::string name;
+    std::vector<std::string> states;
+    std::vector<bool> accepting;
+    std::vector<std::array<std::uint32_t, 256>> next; // next[s][byte] — следующее состояние
+    std::uint32_t start = 0;
+
+    size_t size() const { return states.size(); }
+
+    /// Номер тупикового состояния (всегда последнее).
+    std::uint32_t dead() const { return static_cast<std::uint32_t>(states.size() - 1); }
+
+    /**
+     * Разбирает описание автомата.
+     *
+     * @throws std::runtime_error с номером строки при ошибке в описании.
+     */
+    static Dfa parse(std::string_view text)
+    {
+        Dfa dfa;
+        std::vector<std::array<std::int64_t, 256>> edges; // -1 — переход не задан
+        std::unordered_map<std::string, std::uint32_t> numbers;
+        auto state = [&](const std::string &name)
+        {
+            auto [it, added] = numbers.emplace(name, static_cast<std::uint32_t>(dfa.states.size()));
+            if (!added)
+                return it->second;
+            dfa.states.push_back(name);
+            dfa.accepting.push_back(false);
+            edges.emplace_back();
+            edges.back().fill(-1);
+            return static_cast<std::uint32_t>(dfa.states.size() - 1);
+        };
+
+        std::istringstream in{std::string(text)};
+        std::string line;
+        bool hasStart = false;
+        for (int number = 1; std::getline(in, line); ++number)
+        {
+            line = line.substr(0, line.find('#'));
+            std::istringstream words(line);
+            std::string first, second, third;
+            if (!(words >> first))
+                continue;
+            auto fail = [&](const std::string &message)
+            { throw std::runtime_error("строка " + std::to_string(number) + ": " + message); };
+
+            if (first == "name")
+            {
+                if (!(words >> dfa.name))
+                    fail("ожидалось имя автомата");
+            }
+            else if (first == "start")
+            {
+                if (!(words >> second))
+                    fail("ожидалось начальное состояние");
+                dfa.start = state(second);
+                hasStart = true;
+            }
+            else if (first == "accept")
+            {
+                while (words >> second)
+                    dfa.accepting[state(second)] = true;
+            }
+            else
+            {
+                if (!(words >> second >> third) || second.size() != 1)
+                    fail("ожидался переход <состояние> <символ> <состояние>");
+                std::uint32_t from = state(first), to = state(third);
+                auto &edge = edges[from][static_cast<unsigned char>(second[0])];
+                if (edge != -1 && edge != to)
+                    fail("переход из " + first + " по '" + second + "' задан дважды");
+                edge = to;
+            }
+        }
+        if (!hasStart)
+            throw std::runtime_error("не задано начальное состояние");
+        if (dfa.name.empty())
+            dfa.name = "dfa";
+
+        std::uint32_t dead = state("dead");
+        for (size_t s = 0; s < dfa.states.size(); ++s)
+        {
+            dfa.next.emplace_back();
+            for (int c = 0; c < 256; ++c)
+                dfa.next[s][c] = edges[s][c] == -1 ? dead : static_cast<std::uint32_t>(edges[s][c]);
+        }
+        return dfa;
+    }
+
+    /**
+     * Ловушки: состояния, из которых не достижимо ни одно принимающее.
+     * Попав в ловушку, распознаватель может сразу вернуть false.
+     */
+    std::vector<bool> traps() const
+    {
+        std::vector<bool> live(accepting.begin(), accepting.end());
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (size_t s = 0; s < size(); ++s)
+            {
+                if (live[s])
+                    continue;
+                for (int c = 0; c < 256 && !live[s]; ++c)
+                    live[s] = live[next[s][c]];
+                changed |= live[s];
+            }
+        }
+        std::vector<bool> result(size());
+        for (size_t s = 0; s < size(); ++s)
+            result[s] = !live[s];
+        return result;
+    }
+};
+
+/**
+ * Случайный автомат для тестов и замеров: states состояний, переходы по символам
+ * alphabet выбираются случайно, примерно четверть состояний — принимающие.
+ */
+Dfa randomDfa(size_t states, const std::string &alphabet, unsigned seed = 42)
+{
+    std::mt19937 rng(seed);
+    std::string spec = "name random\nstart s0\naccept";
+    for (size_t s = 0; s < states; ++s)
+    {
+        if (rng() % 4 == 0)
+            spec += " s" + std::to_string(s);
+    }
+    spec += "\n";
+    for (size_t s = 0; s < states; ++s)
+    {
+        for (char c : alphabet)
+            spec += "s" + std::to_string(s) + " " + c + " s" + std::to_string(rng() % states) + "\n";
+    }
+    return Dfa::parse(spec);
+}
+
+/**
+ * Табличный распознаватель: один переход — одно чтение из таблицы
+ * состояний × 256 байтов.
+ */
+class DfaTable
+{
+    std::vector<std::uint32_t> table; // table[s * 256 + byte]
+    std::vector<bool> accepting;
+    std::uint32_t start;
+
+public:
+    explicit DfaTable(const Dfa &dfa) : table(dfa.size() * 256), accepting(dfa.accepting), start(dfa.start)
+    {
+        for (size_t s = 0; s < dfa.size(); ++s)
+        {
+            for (int c = 0; c < 256; ++c)
+                table[s * 256 + c] = dfa.next[s][c];
+        }
+    }
+
+    std::uint32_t initial() const { return start; }
+    bool accepts(std::uint32_t state) const { return accepting[state]; }
+
+    /// Состояние после чтения data[0, n) из состояния state.
+    std::uint32_t run(std::uint32_t state, const char *data, size_t n) const
+    {
+        const std::uint32_t *t = table.data();
+        for (size_t i = 0; i < n; ++i)
+            state = t[state * 256 + static_cast<unsigned char>(data[i])];
+        return state;
+    }
+
+    bool accepts(const char *data, size_t n) const { return accepting[run(start, data, n)]; }
+};
@@ -0,0 +1,125 @@
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "dfa.hpp"
+
+/**
+ * Генератор прямого кода для автомата: каждое состояние становится меткой,
+ * переходы — оператором switch по очередному байту и goto на метку цели.
+ * Переходы в ловушки заменяются немедленным return false.
+ *
+ * Использование: dfagen.exe <описание.dfa> > <файл.hpp>
+ * В заголовок попадают функция <имя>Direct(const char *, size_t) и
+ * исходное описание <имя>Spec для табличного распознавателя.
+ */
+
+/// Литерал для метки case: печатные символы — как есть, остальные — числом.
+std::string caseLabel(int c)
+{
+    if (c > ' ' && c < 127 && c != '\'' && c != '\\')
+        return std::string("'") + static_cast<char>(c) + "'";
+    return std::to_string(c);
+}
+
+void generate(const Dfa &dfa, const std::string &spec, const std::string &source, std::ostream &out)
+{
+    std::vector<bool> traps = dfa.traps();
+
+    // Генерируются только состояния, достижимые из начального и не являющиеся ловушками
+    std::vector<bool> reachable(dfa.size());
+    std::vector<std::uint32_t> stack = {dfa.start};
+    reachable[dfa.start] = true;
+    while (!stack.empty())
+    {
+        std::uint32_t s = stack.back();
+        stack.pop_back();
+        for (int c = 0; c < 256; ++c)
+        {
+            std::uint32_t t = dfa.next[s][c];
+            if (!reachable[t] && !traps[t])
+            {
+                reachable[t] = true;
+                stack.push_back(t);
+            }
+        }
+    }
+
+    auto jump = [&](std::uint32_t t)
+    { return traps[t] ? std::string("return false;") : "goto s" + std::to_string(t) + ";"; };
+
+    out << "// Сгенерировано dfagen.exe из " << source << ", не редактировать вручную.\n"
+        << "#pragma once\n\n#include <cstddef>\n\n"
+        << "/// Описание автомата " << dfa.name << " для табличного распознавателя.\n"
+        << "inline constexpr char " << dfa.name << "Spec[] = R\"DFA(" << spec << ")DFA\";\n\n"
+        << "/**\n * Прямо закодированный автомат " << dfa.name << ".\n *\n"
+        << " * @return true, если data[0, n) допускается автоматом.\n */\n"
+        << "bool " << dfa.name << "Direct(const char *data, std::size_t n)\n{\n"
+        << "    const unsigned char *p = reinterpret_cast<const unsigned char *>(data);\n"
+        << "    const unsigned char *end = p + n;\n";
+    if (traps[dfa.start])
+    {
+        out << "    (void)p;\n    (void)end;\n    return false;\n}\n";
+        return;
+    }
+    out << "    goto s" << dfa.start << ";\n";
+
+    for (size_t s = 0; s < dfa.size(); ++s)
+    {
+        if (!reachable[s])
+            continue;
+        // Чаще всего встречающаяся цель уходит в default
+        std::map<std::uint32_t, std::vector<int>> byTarget;
+        for (int c = 0; c < 256; ++c)
+            byTarget[dfa.next[s][c]].push_back(c);
+        std::uint32_t fallback = byTarget.begin()->first;
+        for (const auto &[target, bytes] : byTarget)
+        {
+            if (bytes.size() > byTarget[fallback].size())
+                fallback = target;
+        }
+
+        out << "s" << s << ": // " << dfa.states[s] << "\n"
+            << "    if (p == end)\n        return " << (dfa.accepting[s] ? "true" : "false") << ";\n"
+            << "    switch (*p++)\n    {\n";
+        for (const auto &[target, bytes] : byTarget)
+        {
+            if (target == fallback)
+                continue;
+            for (int c : bytes)
+                out << "    case " << caseLabel(c) << ":\n";
+            out << "        " << jump(target) << "\n";
+        }
+        out << "    default:\n        " << jump(fallback) << "\n    }\n";
+    }
+    out << "}\n";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Использование: " << argv[0] << " <описание.dfa>\n";
+        return 1;
+    }
+    std::ifstream file(argv[1]);
+    if (!file)
+    {
+        std::cerr << "Не удалось открыть " << argv[1] << "\n";
+        return 1;
+    }
+    std::stringstream spec;
+    spec << file.rdbuf();
+
+    try
+    {
+        generate(Dfa::parse(spec.str()), spec.str(), argv[1], std::cout);
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << argv[1] << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <cstring>
+#include <map>
+#include <tuple>
+
+#include "dfa.hpp"
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define DFA_JIT_X86_64 1
+#endif
+
+/**
+ * JIT-компиляция автомата в машинный код x86-64.
+ *
+ * Алфавит сжимается до классов байтов (как в StrideDfa), и каждое состояние
+ * становится блоком кода:
+ *     L_s: cmp rdi, rsi; je done_s            ; конец входа
+ *          movzx eax, byte [rdi]
+ *          movzx eax, byte [rdx + rax]        ; класс байта
+ *          inc rdi
+ *          cmp eax, k; je L_t ... jmp L_t     ; если целей немного
+ *          или переход по таблице смещений    ; если их много
+ *     done_s: mov eax, s; ret
+ * Вход к блоку состояния ecx — тоже переход по таблице смещений.
+ * Поглощающие ловушки (все переходы в себя) сразу возвращают своё состояние,
+ * не дочитывая вход. Аргументы: rdi — начало, rsi — конец, rdx — таблица
+ * классов, ecx — состояние на входе; результат — состояние после чтения.
+ * Код пишется в буфер mmap и затем переключается на исполнение (W^X).
+ * На других платформах и при ошибке mmap работает табличный распознаватель.
+ */
+class JitDfa
+{
+    using Entry = std::uint32_t (*)(const unsigned char *p, const unsigned char *end, const unsigned char *classes,
+                                    std::uint32_t state);
+
+    DfaTable fallback;
+    std::array<unsigned char, 256> classOf{};
+    void *memory = nullptr;
+    size_t capacity = 0;
+    Entry entry = nullptr;
+
+#ifdef DFA_JIT_X86_64
+    /// Сравнений подряд, после которых выгоднее переход по таблице.
+    static constexpr size_t MaxCompares = 4;
+
+    std::vector<unsigned char> code;
+
+    void bytes(std::initializer_list<unsigned char> b) { code.insert(code.end(), b); }
+    void imm32(std::uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i)
+            code.push_back(static_cast<unsigned char>(v >> (8 * i)));
+    }
+    void put32(size_t at, std::int64_t v)
+    {
+        auto u = static_cast<std::uint32_t>(v);
+        std::memcpy(&code[at], &u, 4);
+    }
+
+    void emit(const Dfa &dfa, const std::vector<int> &representative)
+    {
+        size_t states = dfa.size(), classes = representative.size();
+        std::vector<size_t> label(states);
+        std::vector<std::pair<size_t, std::uint32_t>> jumps;             // Поле rel32 → состояние
+        std::vector<std::tuple<size_t, size_t, std::uint32_t>> tableRefs; // Поле, начало таблицы → состояние
+        auto jump = [&](std::initializer_list<unsigned char> opcode, std::uint32_t target)
+        {
+            bytes(opcode);
+            jumps.push_back({code.size(), target});
+            imm32(0);
+        };
+        // Переход по таблице смещений, индекс — в rax; target(i) — состояние i-й записи
+        auto jumpTable = [&](size_t size, auto target)
+        {
+            bytes({0x4C, 0x8D, 0x05}); // lea r8, [rip + table]
+            size_t lea = code.size();
+            imm32(0);
+            bytes({0x49, 0x63, 0x04, 0x80}); // movsxd rax, dword [r8 + rax * 4]
+            bytes({0x4C, 0x01, 0xC0});       // add rax, r8
+            bytes({0xFF, 0xE0});             // jmp rax
+            size_t table = code.size();
+            put32(lea, static_cast<std::int64_t>(table) - static_cast<std::int64_t>(lea + 4));
+            for (size_t i = 0; i < size; ++i)
+            {
+                tableRefs.emplace_back(code.size(), table, target(i));
+                imm32(0);
+            }
+        };
+
+        // Вход: переход к блоку состояния ecx по таблице; неизвестное состояние возвращается как есть
+        bytes({0x81, 0xF9}); // cmp ecx, states
+        imm32(static_cast<std::uint32_t>(states));
+        bytes({0x89, 0xC8});       // mov eax, ecx
+        bytes({0x0F, 0x83});       // jae out
+        size_t out = code.size();
+        imm32(0);
+        jumpTable(states, [](size_t s) { return static_cast<std::uint32_t>(s); });
+        put32(out, static_cast<std::int64_t>(code.size()) - static_cast<std::int64_t>(out + 4));
+        bytes({0xC3}); // out: ret
+
+        for (std::uint32_t s = 0; s < states; ++s)
+        {
+            label[s] = code.size();
+            bool absorbing = true;
+            for (size_t k = 0; k < classes; ++k)
+                absorbing = absorbing && dfa.next[s][representative[k]] == s;
+            if (absorbing)
+            {
+                bytes({0xB8}); // mov eax, s; ret
+                imm32(s);
+                bytes({0xC3});
+                continue;
+            }
+
+            bytes({0x48, 0x39, 0xF7}); // cmp rdi, rsi
+            bytes({0x0F, 0x84});       // je done_s
+            size_t done = code.size();
+            imm32(0);
+            bytes({0x0F, 0xB6, 0x07});       // movzx eax, byte [rdi]
+            bytes({0x0F, 0xB6, 0x04, 0x02}); // movzx eax, byte [rdx + rax]
+            bytes({0x48, 0xFF, 0xC7});       // inc rdi
+
+            // Самая частая цель — переход по умолчанию
+            std::map<std::uint32_t, std::vector<std::uint32_t>> byTarget;
+            for (size_t k = 0; k < classes; ++k)
+                byTarget[dfa.next[s][representative[k]]].push_back(static_cast<std::uint32_t>(k));
+            std::uint32_t fallbackTarget = byTarget.begin()->first;
+            for (const auto &[target, list] : byTarget)
+            {
+                if (list.size() > byTarget[fallbackTarget].size())
+                    fallbackTarget = target;
+            }
+
+            if (classes - byTarget[fallbackTarget].size() <= MaxCompares)
+            {
+                for (const auto &[target, list] : byTarget)
+                {
+                    if (target == fallbackTarget)
+                        continue;
+                    for (std::uint32_t k : list)
+                    {
+                        bytes({0x3D}); // cmp eax, imm32
+                        imm32(k);
+                        jump({0x0F, 0x84}, target); // je L_t
+                    }
+                }
+                jump({0xE9}, fallbackTarget); // jmp L_t
+            }
+            else
+            {
+                jumpTable(classes, [&](size_t k) { return dfa.next[s][representative[k]]; });
+            }
+
+            put32(done, static_cast<std::int64_t>(code.size()) - static_cast<std::int64_t>(done + 4));
+            bytes({0xB8}); // done_s: mov eax, s; ret
+            imm32(s);
+            bytes({0xC3});
+        }
+
+        for (auto [field, target] : jumps)
+            put32(field, static_cast<std::int64_t>(label[target]) - static_cast<std::int64_t>(field + 4));
+        for (auto [field, table, target] : tableRefs)
+            put32(field, static_cast<std::int64_t>(label[target]) - static_cast<std::int64_t>(table));
+    }
+
+    /// Копирует код в исполняемую память; при ошибке ничего не остаётся отображённым.
+    bool install()
+    {
+        capacity = code.size();
+        memory = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            memory = nullptr;
+            capacity = 0;
+            return false;
+        }
+        std::memcpy(memory, code.data(), code.size());
+        if (mprotect(memory, capacity, PROT_READ | PROT_EXEC) != 0)
+        {
+            munmap(memory, capacity);
+            memory = nullptr;
+            capacity = 0;
+            return false;
+        }
+        return true;
+    }
+#endif
+
+public:
+    /**
+     * @param allowNative false — не компилировать, всегда использовать таблицу.
+     */
+    explicit JitDfa(const Dfa &dfa, bool allowNative = true) : fallback(dfa)
+    {
+        // Сжатие алфавита: байты с одинаковыми столбцами переходов — один класс
+        std::map<std::vector<std::uint32_t>, unsigned char> columns;
+        std::vector<int> representative;
+        for (int c = 0; c < 256; ++c)
+        {
+            std::vector<std::uint32_t> column(dfa.size());
+            for (size_t s = 0; s < dfa.size(); ++s)
+                column[s] = dfa.next[s][c];
+            auto [it, added] = columns.emplace(column, static_cast<unsigned char>(columns.size()));
+            if (added)
+                representative.push_back(c);
+            classOf[c] = it->second;
+        }
+#ifdef DFA_JIT_X86_64
+        if (allowNative)
+        {
+            emit(dfa, representative);
+            // При ошибке mmap или mprotect остаётся табличный распознаватель
+            entry = install() ? reinterpret_cast<Entry>(memory) : nullptr;
+            code = {};
+        }
+#else
+        (void)allowNative;
+#endif
+    }
+
+    JitDfa(const JitDfa &) = delete;
+    JitDfa &operator=(const JitDfa &) = delete;
+
+    ~JitDfa()
+    {
+#ifdef DFA_JIT_X86_64
+        if (memory)
+            munmap(memory, capacity);
+#endif
+    }
+
+    /// true, если автомат выполняется машинным кодом.
+    bool native() const { return entry != nullptr; }
+
+    /// Размер сгенерированного кода в байтах.
+    size_t codeBytes() const { return entry ? capacity : 0; }
+
+    std::uint32_t initial() const { return fallback.initial(); }
+    bool accepts(std::uint32_t state) const { return fallback.accepts(state); }
+
+    /// Состояние после чтения data[0, n) из состояния state.
+    std::uint32_t run(std::uint32_t state, const char *data, size_t n) const
+    {
+        if (!entry)
+            return fallback.run(state, data, n);
+        const auto *p = reinterpret_cast<const unsigned char *>(data);
+        return entry(p, p + n, classOf.data(), state);
+    }
+
+    bool accepts(const char *data, size_t n) const { return accepts(run(initial(), data, n)); }
+};
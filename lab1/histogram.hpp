@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "runs.hpp"
+
+/**
+ * Гистограмма длин максимальных серий нулей и единиц.
+ *
+ * Длины до Exact включительно считаются точно, более длинные — по корзинам
+ * [2^k, 2^(k+1)). Попутно запоминаются максимальные длины серий и число
+ * недопустимых символов, так что по гистограмме можно получить и ответ
+ * dfaOddConsecutive.
+ */
+struct RunHistogram
+{
+    static constexpr size_t Exact = 64;
+    std::uint64_t exact[2][Exact + 1] = {};  // exact[s][len] — число серий символа s длины len
+    std::uint64_t buckets[2][64] = {};       // buckets[s][k] — длины из [2^k, 2^(k+1)), больше Exact
+    std::uint64_t maxRun[2] = {};            // Максимальная длина серии символа s
+    std::uint64_t invalid = 0;               // Число недопустимых символов
+
+    void add(const Run &run)
+    {
+        if (run.symbol != '0' && run.symbol != '1')
+        {
+            invalid += run.length;
+            return;
+        }
+        int s = run.symbol - '0';
+        if (run.length <= Exact)
+            exact[s][run.length]++;
+        else
+            buckets[s][63 - __builtin_clzll(run.length)]++;
+        maxRun[s] = std::max(maxRun[s], run.length);
+    }
+
+    void merge(const RunHistogram &other)
+    {
+        for (int s = 0; s < 2; ++s)
+        {
+            for (size_t i = 0; i <= Exact; ++i)
+                exact[s][i] += other.exact[s][i];
+            for (size_t k = 0; k < 64; ++k)
+                buckets[s][k] += other.buckets[s][k];
+            maxRun[s] = std::max(maxRun[s], other.maxRun[s]);
+        }
+        invalid += other.invalid;
+    }
+
+    /// То же, что dfaOddConsecutive для всей обработанной строки.
+    bool oddConsecutive() const
+    {
+        return invalid == 0 && (maxRun[1] % 2 == 1) && (maxRun[0] % 2 == 1);
+    }
+};
+
+/**
+ * Строит гистограмму длин серий за один проход RunScanner.
+ *
+ * Вход делится на части по числу потоков; каждый поток считает свою гистограмму,
+ * откладывая первую и последнюю серии части, потому что они могут продолжаться
+ * в соседних частях. Затем гистограммы сливаются, а отложенные серии склеиваются
+ * по границам частей.
+ *
+ * @param threads Число потоков (0 — по числу ядер).
+ */
+RunHistogram runHistogram(const char *data, size_t n, size_t threads = 0)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, n / (1 << 16) + 1));
+
+    struct Part
+    {
+        RunHistogram histogram; // Внутренние серии части
+        Run first{}, last{};    // Крайние серии (возможно, неполные)
+        bool single = true;     // Вся часть — одна серия (first не заполнена)
+    };
+    std::vector<Part> parts(threads);
+    std::vector<std::thread> workers;
+
+    auto work = [&](size_t t)
+    {
+        size_t begin = n * t / threads, end = n * (t + 1) / threads;
+        Part &part = parts[t];
+        RunScanner scanner;
+        scanner.scan(data + begin, end - begin, [&](const Run &run)
+                     {
+                         if (part.single)
+                         {
+                             part.first = run;
+                             part.single = false;
+                         }
+                         else
+                             part.histogram.add(run); });
+        scanner.finish([&](const Run &run)
+                       { part.last = Run{run.symbol, run.offset + begin, run.length}; });
+        part.first.offset += begin;
+    };
+    for (size_t t = 1; t < threads; ++t)
+        workers.emplace_back(work, t);
+    work(0);
+    for (auto &worker : workers)
+        worker.join();
+
+    // Склейка: pending — серия, которая может продолжиться в следующей части
+    RunHistogram result;
+    Run pending{};
+    bool hasPending = false;
+    auto extend = [&](const Run &run)
+    {
+        if (run.length == 0)
+            return;
+        if (hasPending && pending.symbol == run.symbol)
+        {
+            pending.length += run.length;
+            return;
+        }
+        if (hasPending)
+            result.add(pending);
+        pending = run;
+        hasPending = true;
+    };
+    for (const Part &part : parts)
+    {
+        if (!part.single)
+        {
+            extend(part.first);
+            result.add(pending);
+            hasPending = false;
+        }
+        result.merge(part.histogram);
+        extend(part.last);
+    }
+    if (hasPending)
+        result.add(pending);
+    return result;
+}
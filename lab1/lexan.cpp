@@ -1,77 +1,20 @@
 #include <iostream>
-#include <string>
 #include <vector>
 
-using namespace std;
-/**
- * Функция dfaOddConsecutive реализует детерминированный конечный автомат (DFA),
- * который проверяет строку на наличие подцепочек с нечётным количеством подряд идущих '1' и '0'.
- *
- * Данный автомат построен на принципе подсчёта максимально длинных последовательных блоков единиц и нулей,
- * и проверяет, чтобы эти максимальные длины были нечётными.
- *
- * @param str Входная строка, состоящая из символов '0' и '1'.
- * @return true, если в строке есть подцепочки с нечётным числом подряд идущих единиц и нулей.
- *         false, если условие не выполнено или в строке есть недопустимые символы.
- */
-bool dfaOddConsecutive(const std::string &str)
-{
-    // Счётчик для текущей последовательности единиц
-    int countOne = 0;
-    // Счётчик для текущей последовательности нулей
-    int countZero = 0;
-    // Максимальная длина подряд идущих единиц во всей строке
-    int maxOne = 0;
-    // Максимальная длина подряд идущих нулей во всей строке
-    int maxZero = 0;
-    // Последний обработанный символ
-    char last = '\0';
-
-    // Проходим по каждому символу строки
-    for (char c : str)
-    {
-        if (c == '1')
-        {
-            // Если текущий символ равен '1' и предыдущий тоже '1' – увеличиваем счётчик подряд идущих единиц
-            if (last == '1')
-            {
-                countOne++;
-            }
-            else
-            {
-                // Иначе начинаем новый подсчёт одиниц
-                countOne = 1;
-            }
-            // Обновляем максимальную длину подряд идущих единиц
-            maxOne = std::max(maxOne, countOne);
-            // Сбрасываем счётчик нулей, так как текущий символ '1'
-            countZero = 0;
-        }
-        else if (c == '0')
-        {
-            // Аналогично для нулей
-            if (last == '0')
-            {
-                countZero++;
-            }
-            else
-            {
-                countZero = 1;
-            }
-            maxZero = std::max(maxZero, countZero);
-            countOne = 0;
-        }
-        else
-        {
-            // Если встречен недопустимый символ — сразу возвращаем false
-            return false;
-        }
-        last = c; // Запоминаем текущий символ как последний
-    }
+#include "lexan.hpp"
+#include "runindex.hpp"
+#include "window.hpp"
+#include "runs.hpp"
+#include "histogram.hpp"
+#include "dfa.hpp"
+#include "oddruns_dfa.hpp"
+#include "pairs_dfa.hpp"
+#include "stride.hpp"
+#include "speculative.hpp"
+#include "bitmatch.hpp"
+#include "dfajit.hpp"
+#include <random>
 
-    // Возвращаем true только если максимальная длина подряд идущих единиц и нулей — нечетная
-    return (maxOne % 2 == 1) && (maxZero % 2 == 1);
-}
 struct TestCase
 {
     std::string input;
@@ -122,6 +65,417 @@ int main()
             passed++;
     }
 
+    // Индекс по подстрокам: ответы должны совпадать с dfaOddConsecutive на копии подстроки
+    {
+        std::mt19937 rng(2025);
+        std::string bits;
+        for (int i = 0; i < 5000; ++i)
+        {
+            bits += std::string(1 + rng() % 4, rng() % 2 ? '1' : '0');
+        }
+        bits[1234] = 'x';
+        OddRunIndex index(bits);
+
+        int agree = 0, queries = 20000;
+        for (int q = 0; q < queries; ++q)
+        {
+            size_t l = rng() % bits.size(), r = l + rng() % 40;
+            r = std::min(r, bits.size());
+            agree += index.query(l, r) == dfaOddConsecutive(bits.substr(l, r - l));
+        }
+        bool success = agree == queries;
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Индекс подстрок: совпало " << agree
+                  << " из " << queries << " запросов\n";
+        passed += success;
+        total++;
+    }
+
+    // Скользящее окно: изменения свойства должны совпадать с пересчётом каждого окна
+    {
+        std::mt19937 rng(7);
+        std::string stream;
+        for (int i = 0; i < 3000; ++i)
+        {
+            stream += std::string(1 + rng() % 5, rng() % 2 ? '1' : '0');
+        }
+
+        const size_t width = 37;
+        std::vector<std::pair<std::uint64_t, bool>> expected, actual;
+        bool last = false;
+        for (size_t end = 1; end <= stream.size(); ++end)
+        {
+            size_t begin = end > width ? end - width : 0;
+            bool now = dfaOddConsecutive(stream.substr(begin, end - begin));
+            if (now != last)
+                expected.push_back({end, now});
+            last = now;
+        }
+
+        OddRunWindow window(width);
+        for (size_t pos = 0; pos < stream.size();)
+        {
+            size_t chunk = 1 + rng() % 100;
+            window.feed(std::string_view(stream).substr(pos, chunk), [&](std::uint64_t at, bool value)
+                        { actual.push_back({at, value}); });
+            pos += chunk;
+        }
+
+        bool success = actual == expected;
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Скользящее окно: " << actual.size()
+                  << " изменений свойства, ожидалось " << expected.size() << "\n";
+        passed += success;
+        total++;
+    }
+
+    // Вход в виде RLE: серии дробятся на части и перемежаются пустыми парами
+    {
+        std::mt19937 rng(11);
+        int agree = 0, cases = 2000;
+        for (int t = 0; t < cases; ++t)
+        {
+            std::string bits;
+            std::vector<std::pair<char, std::uint64_t>> runs;
+            for (int r = 0, n = rng() % 8; r < n; ++r)
+            {
+                char c = rng() % 2 ? '1' : '0';
+                std::uint64_t length = rng() % 5;
+                bits += std::string(length, c);
+                runs.push_back({c, length});
+            }
+            if (t % 100 == 0)
+            {
+                bits += '2';
+                runs.push_back({'2', 1});
+            }
+            agree += dfaOddConsecutiveRLE(runs) == dfaOddConsecutive(bits);
+        }
+        bool success = agree == cases;
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Вход RLE: совпало " << agree << " из " << cases << "\n";
+        passed += success;
+        total++;
+    }
+
+    // Позиции нечётных серий: потоковый поиск по порциям против прямого перебора
+    {
+        std::mt19937 rng(13);
+        std::string bits;
+        for (int i = 0; i < 4000; ++i)
+        {
+            bits += std::string(1 + rng() % 40, "01x"[rng() % 3]);
+        }
+
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> expected, actual;
+        for (size_t i = 0, j; i < bits.size(); i = j)
+        {
+            for (j = i; j < bits.size() && bits[j] == bits[i]; ++j)
+                ;
+            if (bits[i] != 'x' && (j - i) % 2 == 1)
+                expected.push_back({i, j - i});
+        }
+
+        OddRunReporter reporter;
+        auto collect = [&](const Run &run)
+        { actual.push_back({run.offset, run.length}); };
+        for (size_t pos = 0; pos < bits.size();)
+        {
+            size_t chunk = std::min<size_t>(1 + rng() % 300, bits.size() - pos);
+            reporter.feed(bits.data() + pos, chunk, collect);
+            pos += chunk;
+        }
+        reporter.finish(collect);
+
+        bool success = actual == expected;
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Нечётные серии: найдено " << actual.size()
+                  << ", ожидалось " << expected.size() << "\n";
+        passed += success;
+        total++;
+    }
+
+    // Вывод серий: полная запись и отказ записи на переполненное устройство
+    {
+        std::FILE *file = std::tmpfile();
+        std::FILE *full = std::fopen("/dev/full", "w");
+        bool written = false, reported = true;
+        if (file)
+        {
+            {
+                RunWriter writer(file);
+                writer({'1', ~std::uint64_t(0), ~std::uint64_t(0)});
+                writer({'0', 0, 1});
+                written = writer.flush();
+            }
+            std::rewind(file);
+            char text[64] = {};
+            size_t n = std::fread(text, 1, sizeof(text) - 1, file);
+            written = written && std::string(text, n) == "18446744073709551615 18446744073709551615 1\n0 1 0\n";
+            std::fclose(file);
+        }
+        if (full)
+        {
+            {
+                RunWriter writer(full);
+                writer({'1', 0, 1});
+                reported = !writer.flush() && !writer.good();
+            }
+            std::fclose(full);
+        }
+        bool success = written && reported;
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Вывод серий: запись " << (written ? "верна" : "неверна")
+                  << ", ошибка записи " << (reported ? "обнаружена" : "пропущена") << "\n";
+        passed += success;
+        total++;
+    }
+
+    // Гистограмма серий: разбиение на части по потокам против прямого подсчёта
+    {
+        std::mt19937 rng(17);
+        std::string bits;
+        for (int i = 0; i < 6000; ++i)
+        {
+            size_t length = rng() % 10 == 0 ? 1 + rng() % 5000 : 1 + rng() % 70;
+            bits += std::string(length, "01"[i % 2]);
+        }
+
+        RunHistogram expected;
+        for (size_t i = 0, j; i < bits.size(); i = j)
+        {
+            for (j = i; j < bits.size() && bits[j] == bits[i]; ++j)
+                ;
+            expected.add(Run{bits[i], i, j - i});
+        }
+
+        bool success = true;
+        for (size_t threads : {1, 2, 3, 8})
+        {
+            RunHistogram actual = runHistogram(bits.data(), bits.size(), threads);
+            success = success && std::equal(&actual.exact[0][0], &actual.exact[0][0] + 2 * (RunHistogram::Exact + 1), &expected.exact[0][0]) &&
+                      std::equal(&actual.buckets[0][0], &actual.buckets[0][0] + 2 * 64, &expected.buckets[0][0]) &&
+                      actual.maxRun[0] == expected.maxRun[0] && actual.maxRun[1] == expected.maxRun[1] &&
+                      actual.oddConsecutive() == dfaOddConsecutive(bits);
+        }
+        bits[bits.size() / 2] = 'x';
+        success = success && !runHistogram(bits.data(), bits.size(), 4).oddConsecutive();
+
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Гистограмма серий\n";
+        passed += success;
+        total++;
+    }
+
+    // Автоматы из описаний: прямой код против таблицы и прямого разбора на серии
+    {
+        DfaTable oddTable(Dfa::parse(oddRunsSpec)), pairsTable(Dfa::parse(pairsSpec));
+        std::mt19937 rng(19);
+        const int cases = 3000;
+        int agree = 0;
+        for (int t = 0; t < cases; ++t)
+        {
+            std::string bits;
+            for (int r = rng() % 8; r >= 0; --r)
+                bits += std::string(1 + rng() % 5, rng() % 50 ? "01"[rng() % 2] : 'x');
+
+            // Серии: все ли из 0/1, все ли нечётны, все ли чётны, есть ли оба символа
+            bool valid = true, allOdd = true, allEven = true, seen[2] = {false, false};
+            for (size_t i = 0, j; i < bits.size(); i = j)
+            {
+                for (j = i; j < bits.size() && bits[j] == bits[i]; ++j)
+                    ;
+                valid = valid && bits[i] != 'x';
+                seen[bits[i] == '1'] = true;
+                allOdd = allOdd && (j - i) % 2 == 1;
+                allEven = allEven && (j - i) % 2 == 0;
+            }
+            bool odd = valid && allOdd && seen[0] && seen[1];
+            bool pairs = valid && allEven;
+
+            agree += oddRunsDirect(bits.data(), bits.size()) == odd &&
+                     oddTable.accepts(bits.data(), bits.size()) == odd &&
+                     pairsDirect(bits.data(), bits.size()) == pairs &&
+                     pairsTable.accepts(bits.data(), bits.size()) == pairs &&
+                     (!odd || dfaOddConsecutive(bits));
+        }
+        bool success = agree == cases;
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Автоматы из описаний: совпало " << agree << " из " << cases << "\n";
+        passed += success;
+        total++;
+    }
+
+    // Многобайтовый шаг: таблицы с шагом 1..8 против побайтовой таблицы
+    {
+        Dfa dfa = Dfa::parse(oddRunsSpec);
+        DfaTable reference(dfa);
+        std::vector<StrideDfa> engines;
+        for (size_t stride : {1, 2, 3, 4, 8})
+            engines.emplace_back(dfa, stride);
+        engines.emplace_back(dfa);
+        std::mt19937 rng(23);
+        const int cases = 2000;
+        int agree = 0;
+        for (int t = 0; t < cases; ++t)
+        {
+            std::string bits;
+            for (int r = rng() % 12; r >= 0; --r)
+                bits += std::string(1 + rng() % 5, rng() % 50 ? "01"[rng() % 2] : 'x');
+            std::uint32_t expected = reference.run(reference.initial(), bits.data(), bits.size());
+            bool same = true;
+            for (const StrideDfa &engine : engines)
+                same = same && engine.run(engine.initial(), bits.data(), bits.size()) == expected;
+            agree += same;
+        }
+        bool success = agree == cases && engines.back().alphabet() == 3 && engines.back().step() == 4;
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Многобайтовый шаг: совпало " << agree << " из " << cases
+                  << ", классов " << engines.back().alphabet() << ", выбран шаг " << engines.back().step() << "\n";
+        passed += success;
+        total++;
+    }
+
+    // Явно заданный шаг, при котором таблица не помещается в 32-битные смещения
+    {
+        Dfa dfa = Dfa::parse(oddRunsSpec);
+        bool rejected = false;
+        try
+        {
+            StrideDfa engine(dfa, 64);
+        }
+        catch (const std::invalid_argument &)
+        {
+            rejected = true;
+        }
+        StrideDfa explicitStride(dfa, 8);
+        DfaTable reference(dfa);
+        bool success = rejected && explicitStride.step() == 8 &&
+                       explicitStride.accepts("01100111", 8) == reference.accepts("01100111", 8);
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Слишком большой шаг отвергнут, шаг 8 работает\n";
+        passed += success;
+        total++;
+    }
+
+    // Спекулятивный параллельный запуск против последовательной таблицы
+    {
+        Dfa dfa = Dfa::parse(oddRunsSpec);
+        DfaTable reference(dfa);
+        SpeculativeDfa trained(dfa), untrained(dfa);
+        std::mt19937 rng(29);
+        auto generate = [&](size_t n, bool valid)
+        {
+            std::string bits;
+            for (char c = '0'; bits.size() < n; c = c == '0' ? '1' : '0')
+                bits.append(valid ? 1 + 2 * (rng() % 2) : 1 + rng() % 4, c);
+            return bits;
+        };
+        std::string sample = generate(100000, true);
+        trained.learn(sample.data(), sample.size());
+
+        int agree = 0, cases = 0;
+        size_t trainedMisses = 0;
+        for (bool valid : {true, false})
+        {
+            for (size_t n : {100, 40000, 300000})
+            {
+                std::string bits = generate(n, valid);
+                std::uint32_t expected = reference.run(reference.initial(), bits.data(), bits.size());
+                for (size_t threads : {1, 3, 8})
+                {
+                    SpeculationStats stats;
+                    agree += trained.run(bits.data(), bits.size(), threads, &stats) == expected;
+                    trainedMisses += valid ? stats.mispredicted : 0;
+                    agree += untrained.run(bits.data(), bits.size(), threads) == expected;
+                    cases += 2;
+                }
+            }
+        }
+        bool success = agree == cases && trainedMisses == 0;
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Спекулятивный запуск: совпало " << agree << " из " << cases
+                  << ", ошибок угадывания на похожем входе " << trainedMisses << "\n";
+        passed += success;
+        total++;
+    }
+
+    // Битово-параллельный поиск образцов против std::string::find
+    {
+        std::mt19937 rng(31);
+        const int cases = 300;
+        int agree = 0;
+        for (int t = 0; t < cases; ++t)
+        {
+            std::string bits;
+            for (size_t n = rng() % 700; bits.size() < n;)
+                bits += "01"[rng() % 2];
+            // Образцы: случайные подстроки текста (есть вхождения) и случайные строки
+            std::vector<std::string> patterns;
+            for (int k = 1 + rng() % 6; k > 0; --k)
+            {
+                size_t length = 1 + rng() % 64;
+                std::string pattern;
+                if (rng() % 2 && bits.size() >= length)
+                    pattern = bits.substr(rng() % (bits.size() - length + 1), length);
+                else
+                    for (size_t i = 0; i < length; ++i)
+                        pattern += "01"[rng() % 4 == 0];
+                patterns.push_back(pattern);
+            }
+
+            std::vector<std::pair<size_t, size_t>> expected, actual;
+            for (size_t p = 0; p < patterns.size(); ++p)
+                for (size_t pos = bits.find(patterns[p]); pos != std::string::npos; pos = bits.find(patterns[p], pos + 1))
+                    expected.push_back({p, pos});
+            BitPatternMatcher matcher(patterns);
+            PackedBits text(bits);
+            matcher.find(text, [&](size_t p, size_t pos)
+                         { actual.push_back({p, pos}); });
+            std::sort(expected.begin(), expected.end());
+            std::sort(actual.begin(), actual.end());
+            agree += actual == expected && matcher.containsAny(text) == !expected.empty();
+        }
+        bool success = agree == cases && bitsAvoid("0100101", {"0110"}) && !bitsAvoid("0101101", {"0110"}) &&
+                       !bitsAvoid("01x01", {"0110"});
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "Поиск образцов Shift-Or: совпало " << agree << " из " << cases << "\n";
+        passed += success;
+        total++;
+    }
+
+    // JIT автомата против табличного распознавателя, включая большой случайный автомат
+    {
+        std::pair<Dfa, std::string> automata[] = {{Dfa::parse(oddRunsSpec), "01x"},
+                                                  {Dfa::parse(pairsSpec), "01"},
+                                                  {randomDfa(40, "01"), "012"},
+                                                  {randomDfa(300, "abcdefghijklmnop"), "abcdefghijklmnopq"}};
+        std::mt19937 rng(37);
+        int agree = 0, cases = 0;
+        bool native = true;
+        for (const auto &[dfa, alphabet] : automata)
+        {
+            DfaTable reference(dfa);
+            JitDfa jit(dfa);
+            native = native && jit.native();
+            for (int t = 0; t < 300; ++t)
+            {
+                std::string input;
+                for (size_t n = rng() % 200; input.size() < n;)
+                    input += alphabet[rng() % alphabet.size()];
+                std::uint32_t from = t % 2 ? dfa.start : rng() % dfa.size();
+                agree += jit.run(from, input.data(), input.size()) == reference.run(from, input.data(), input.size());
+                cases++;
+            }
+            // Вход по таблице: каждое состояние на пустом входе возвращается как есть
+            for (std::uint32_t s = 0; s < dfa.size(); ++s)
+            {
+                agree += jit.run(s, "", 0) == s;
+                cases++;
+            }
+#ifdef DFA_JIT_X86_64
+            std::uint32_t unknown = static_cast<std::uint32_t>(dfa.size()) + 7;
+            native = native && jit.run(unknown, "0", 1) == unknown;
+#endif
+        }
+#ifndef DFA_JIT_X86_64
+        native = true; // На других платформах проверяется только запасной путь
+#endif
+        bool success = agree == cases && native;
+        std::cout << (success ? "[ПРОЙДЕН] " : "[ОШИБКА] ") << "JIT автомата: совпало " << agree << " из " << cases << "\n";
+        passed += success;
+        total++;
+    }
+
     std::cout << "\nПройдено тестов: " << passed << " из " << total << "\n";
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Ранговая структура над битовым вектором: rank(p) — число единиц в позициях [0, p)
+ * за O(1) (накопленные суммы по 64-битным словам и popcount внутри слова).
+ */
+class RankBitVector
+{
+    std::vector<std::uint64_t> words;
+    std::vector<std::uint64_t> before; // Число единиц до начала каждого слова
+
+public:
+    explicit RankBitVector(size_t n = 0) : words(n / 64 + 1, 0) {}
+
+    void set(size_t p) { words[p / 64] |= std::uint64_t(1) << (p % 64); }
+
+    /// Завершает построение: вычисляет накопленные суммы.
+    void build()
+    {
+        before.resize(words.size());
+        std::uint64_t total = 0;
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            before[i] = total;
+            total += __builtin_popcountll(words[i]);
+        }
+    }
+
+    std::uint64_t rank(size_t p) const
+    {
+        std::uint64_t mask = (std::uint64_t(1) << (p % 64)) - 1;
+        return before[p / 64] + __builtin_popcountll(words[p / 64] & mask);
+    }
+};
+
+/**
+ * Максимум на отрезке массива за O(1): разреженная таблица строится по максимумам
+ * блоков из 16 элементов, а края запроса досчитываются внутри блоков.
+ * Памяти нужно около n / 16 * log(n) чисел вместо n * log(n).
+ */
+class RangeMax
+{
+    static constexpr size_t Block = 16;
+    std::vector<std::uint32_t> values;
+    std::vector<std::vector<std::uint32_t>> table; // table[k][i] — максимум блоков [i, i + 2^k)
+
+    std::uint32_t scan(size_t from, size_t to) const
+    {
+        std::uint32_t best = 0;
+        for (size_t i = from; i < to; ++i)
+            best = std::max(best, values[i]);
+        return best;
+    }
+
+public:
+    RangeMax() = default;
+
+    explicit RangeMax(std::vector<std::uint32_t> v) : values(std::move(v))
+    {
+        size_t blocks = (values.size() + Block - 1) / Block;
+        table.emplace_back(blocks);
+        for (size_t b = 0; b < blocks; ++b)
+            table[0][b] = scan(b * Block, std::min(values.size(), (b + 1) * Block));
+        for (size_t k = 1; (size_t(1) << k) <= blocks; ++k)
+        {
+            table.emplace_back(blocks - (size_t(1) << k) + 1);
+            for (size_t b = 0; b < table[k].size(); ++b)
+                table[k][b] = std::max(table[k - 1][b], table[k - 1][b + (size_t(1) << (k - 1))]);
+        }
+    }
+
+    /// Максимум values[from, to); 0 для пустого отрезка.
+    std::uint32_t query(size_t from, size_t to) const
+    {
+        if (from >= to)
+            return 0;
+        size_t first = from / Block, last = (to - 1) / Block;
+        if (first == last)
+            return scan(from, to);
+        std::uint32_t best = std::max(scan(from, (first + 1) * Block), scan(last * Block, to));
+        if (first + 1 < last)
+        {
+            size_t k = 63 - __builtin_clzll(last - first - 1);
+            best = std::max({best, table[k][first + 1], table[k][last - (size_t(1) << k)]});
+        }
+        return best;
+    }
+};
+
+/**
+ * Индекс для многократной проверки свойства dfaOddConsecutive на подстроках
+ * одной длинной строки без повторного сканирования.
+ *
+ * Строка один раз разбивается на максимальные серии одинаковых символов.
+ * Запрос [l, r) находит серии, содержащие l и r - 1 (rank по битовому вектору
+ * начал серий), обрезает их по границам запроса, а максимум длин целых серий
+ * между ними берёт из RangeMax отдельно для серий нулей и единиц.
+ * Недопустимые символы учитываются тем же rank по их битовому вектору. Каждый запрос — O(1).
+ * Длины серий хранятся 32-битными числами, поэтому строка должна быть короче 4 ГиБ.
+ */
+class OddRunIndex
+{
+    RankBitVector runStarts;            // Единицы в позициях начал серий
+    std::vector<std::uint64_t> start;   // Начало каждой серии
+    std::vector<char> symbol;           // Символ серии
+    RangeMax zeroRuns, oneRuns;         // Длины серий нулей / единиц (0 для прочих)
+    RankBitVector invalid;              // Единицы в позициях недопустимых символов
+
+public:
+    explicit OddRunIndex(const std::string &str) : runStarts(str.size()), invalid(str.size())
+    {
+        std::vector<std::uint32_t> zeros, ones;
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+            char c = str[i];
+            if (c != '0' && c != '1')
+                invalid.set(i);
+            if (i == 0 || c != str[i - 1])
+            {
+                runStarts.set(i);
+                start.push_back(i);
+                symbol.push_back(c);
+                zeros.push_back(0);
+                ones.push_back(0);
+            }
+            (c == '0' ? zeros : ones).back() += (c == '0' || c == '1');
+        }
+        start.push_back(str.size());
+        runStarts.build();
+        invalid.build();
+        zeroRuns = RangeMax(std::move(zeros));
+        oneRuns = RangeMax(std::move(ones));
+    }
+
+    /**
+     * Проверяет подстроку [l, r) так же, как dfaOddConsecutive(str.substr(l, r - l)).
+     *
+     * @return true, если максимальные длины серий нулей и единиц в подстроке нечётны.
+     */
+    bool query(size_t l, size_t r) const
+    {
+        if (l >= r || invalid.rank(r) != invalid.rank(l))
+            return false;
+
+        size_t first = runStarts.rank(l + 1) - 1;
+        size_t last = runStarts.rank(r) - 1;
+        if (first == last)
+            return false; // Одна серия: другого символа нет, его максимум 0 — чётный
+
+        // Максимумы целых серий между крайними: [0] — нули, [1] — единицы
+        std::uint64_t maxRun[2] = {zeroRuns.query(first + 1, last), oneRuns.query(first + 1, last)};
+        // Крайние серии обрезаны границами запроса
+        std::uint64_t head = start[first + 1] - l, tail = r - start[last];
+        maxRun[symbol[first] == '1'] = std::max(maxRun[symbol[first] == '1'], head);
+        maxRun[symbol[last] == '1'] = std::max(maxRun[symbol[last] == '1'], tail);
+
+        return (maxRun[0] % 2 == 1) && (maxRun[1] % 2 == 1);
+    }
+};
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Максимальная серия одинаковых символов.
+ */
+struct Run
+{
+    char symbol;          // Символ серии
+    std::uint64_t offset; // Позиция первого символа во всём потоке
+    std::uint64_t length; // Длина серии
+};
+
+/**
+ * Потоковое разбиение входа на максимальные серии одинаковых байтов.
+ *
+ * Границы серий ищутся векторно (SSE2): 16 байтов сравниваются со своими
+ * соседями слева одной командой, и по маске movemask перебираются только
+ * позиции смены символа, так что длинные серии пропускаются по 16 байтов.
+ * Серия, не законченная в конце порции, продолжается в следующей.
+ */
+class RunScanner
+{
+    char symbol = '\0';        // Символ текущей серии
+    std::uint64_t start = 0;   // Начало текущей серии
+    std::uint64_t consumed = 0; // Сколько байтов обработано
+    bool open = false;         // Есть ли незавершённая серия
+
+public:
+    /**
+     * Обрабатывает порцию данных, вызывая onRun(const Run &) для каждой завершённой серии.
+     */
+    template <typename Callback>
+    void scan(const char *data, size_t n, Callback &&onRun)
+    {
+        if (n == 0)
+            return;
+        if (!open)
+        {
+            start = consumed;
+            open = true;
+        }
+        else if (data[0] != symbol)
+        {
+            // Серия из предыдущей порции закончилась на её границе
+            onRun(Run{symbol, start, consumed - start});
+            start = consumed;
+        }
+
+        auto boundary = [&](size_t p)
+        {
+            onRun(Run{data[p - 1], start, consumed + p - start});
+            start = consumed + p;
+        };
+
+        size_t i = 1;
+#if defined(__SSE2__)
+        for (; i + 16 <= n; i += 16)
+        {
+            __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i - 1));
+            unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(current, previous))) & 0xFFFF;
+            while (mask)
+            {
+                boundary(i + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; i < n; ++i)
+        {
+            if (data[i] != data[i - 1])
+                boundary(i);
+        }
+        symbol = data[n - 1];
+        consumed += n;
+    }
+
+    /**
+     * Завершает поток: сообщает о последней серии.
+     */
+    template <typename Callback>
+    void finish(Callback &&onRun)
+    {
+        if (open)
+            onRun(Run{symbol, start, consumed - start});
+        open = false;
+    }
+};
+
+/**
+ * Поиск всех максимальных серий нулей и единиц нечётной длины («подцепочек»
+ * из отчёта) с их позициями. Серии сообщаются по мере нахождения.
+ */
+class OddRunReporter
+{
+    RunScanner scanner;
+
+public:
+    template <typename Callback>
+    void feed(const char *data, size_t n, Callback &&onMatch)
+    {
+        scanner.scan(data, n, [&](const Run &run)
+                     {
+                         if ((run.symbol == '0' || run.symbol == '1') && run.length % 2 == 1)
+                             onMatch(run); });
+    }
+
+    template <typename Callback>
+    void finish(Callback &&onMatch)
+    {
+        scanner.finish([&](const Run &run)
+                       {
+                           if ((run.symbol == '0' || run.symbol == '1') && run.length % 2 == 1)
+                               onMatch(run); });
+    }
+};
+
+/**
+ * Сообщает обо всех нечётных сериях строки целиком.
+ */
+template <typename Callback>
+void reportOddRuns(const std::string &str, Callback &&onMatch)
+{
+    OddRunReporter reporter;
+    reporter.feed(str.data(), str.size(), onMatch);
+    reporter.finish(onMatch);
+}
+
+/**
+ * Буферизованный вывод серий строками «позиция длина символ».
+ * Числа форматируются вручную в буфер на 1 МиБ, который сбрасывается
+ * в файл целиком, чтобы вывод не ограничивал скорость поиска.
+ * Ошибка записи (например, переполненный диск) запоминается: после неё
+ * good() возвращает false, а дальнейший вывод отбрасывается.
+ */
+class RunWriter
+{
+    static constexpr size_t Capacity = 1 << 20;
+    /// Самая длинная запись: 20 цифр, пробел, 20 цифр, пробел, символ, перевод строки.
+    static constexpr size_t MaxRecord = 20 + 1 + 20 + 1 + 1 + 1;
+    std::FILE *out;
+    std::unique_ptr<char[]> buffer;
+    size_t used = 0;
+    bool failed = false;
+
+    void number(std::uint64_t v)
+    {
+        char digits[20];
+        int n = 0;
+        do
+        {
+            digits[n++] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while (v);
+        while (n)
+            buffer[used++] = digits[--n];
+    }
+
+public:
+    explicit RunWriter(std::FILE *file) : out(file), buffer(new char[Capacity + MaxRecord]) {}
+    RunWriter(const RunWriter &) = delete;
+    RunWriter &operator=(const RunWriter &) = delete;
+    ~RunWriter() { flush(); }
+
+    void operator()(const Run &run)
+    {
+        // Буфер сбрасывается, как только заполнен на Capacity, поэтому запаса MaxRecord хватает
+        number(run.offset);
+        buffer[used++] = ' ';
+        number(run.length);
+        buffer[used++] = ' ';
+        buffer[used++] = run.symbol;
+        buffer[used++] = '\n';
+        if (used >= Capacity)
+            flush();
+    }
+
+    /**
+     * Записывает накопленное в файл и сбрасывает буфер stdio.
+     *
+     * @return false, если эта или одна из прежних записей не удалась.
+     */
+    bool flush()
+    {
+        if (!failed && used)
+            failed = std::fwrite(buffer.get(), 1, used, out) != used;
+        used = 0;
+        if (!failed)
+            failed = std::fflush(out) != 0;
+        return !failed;
+    }
+
+    /// true, если все записи до сих пор удались.
+    bool good() const { return !failed; }
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#include "stride.hpp"
+
+/**
+ * Счётчики последнего запуска SpeculativeDfa.
+ */
+struct SpeculationStats
+{
+    size_t chunks = 0;          // На сколько частей разбит вход
+    size_t mispredicted = 0;    // Частей, у которых угаданное начальное состояние неверно
+    std::uint64_t rescanned = 0; // Байтов, перечитанных при исправлении
+};
+
+/**
+ * Параллельный запуск автомата с угадыванием состояния на входе в каждую часть.
+ *
+ * Вход делится на части по числу потоков. Первая часть читается из настоящего
+ * начального состояния, остальные — из угаданного: по последним Context байтам
+ * перед частью ищется состояние, чаще всего встречавшееся после такого же
+ * контекста в обучающем префиксе (learn), иначе — просто самое частое.
+ * Затем части проверяются по порядку: если угадано неверно, часть перечитывается
+ * из настоящего состояния, но только до первой контрольной точки (каждые
+ * Checkpoint байтов), где состояние совпало с угаданным путём, — дальше пути
+ * совпадают. Для автоматов, быстро забывающих начало (попадающих в ловушку или
+ * синхронизирующихся на границе серии), исправление почти ничего не стоит.
+ */
+class SpeculativeDfa
+{
+    static constexpr size_t Context = 8;
+    static constexpr size_t Checkpoint = 1 << 14;
+
+    StrideDfa engine;
+    std::uint32_t common;                                      // Самое частое состояние
+    std::unordered_map<std::uint64_t, std::uint32_t> byContext; // Самое частое состояние после контекста
+
+    static std::uint64_t context(const char *data, size_t position)
+    {
+        std::uint64_t key = 0;
+        size_t length = std::min(position, Context);
+        std::memcpy(&key, data + position - length, length);
+        return key;
+    }
+
+public:
+    explicit SpeculativeDfa(const Dfa &dfa) : engine(dfa), common(dfa.start) {}
+
+    /**
+     * Обучает угадывание на префиксе входа: запоминает, в каком состоянии
+     * автомат чаще всего находится после каждого встреченного контекста.
+     */
+    void learn(const char *data, size_t n)
+    {
+        std::unordered_map<std::uint64_t, std::unordered_map<std::uint32_t, std::uint64_t>> counts;
+        std::unordered_map<std::uint32_t, std::uint64_t> total;
+        std::uint32_t state = engine.initial();
+        for (size_t i = 0; i < n; ++i)
+        {
+            state = engine.run(state, data + i, 1);
+            if (i + 1 >= Context)
+                counts[context(data, i + 1)][state]++;
+            total[state]++;
+        }
+
+        auto best = [](const std::unordered_map<std::uint32_t, std::uint64_t> &histogram)
+        {
+            auto it = std::max_element(histogram.begin(), histogram.end(), [](const auto &a, const auto &b)
+                                       { return a.second < b.second || (a.second == b.second && a.first > b.first); });
+            return it->first;
+        };
+        byContext.clear();
+        for (const auto &[key, histogram] : counts)
+            byContext[key] = best(histogram);
+        if (!total.empty())
+            common = best(total);
+    }
+
+    /// Угаданное состояние автомата перед позицией position.
+    std::uint32_t guess(const char *data, size_t position) const
+    {
+        if (position >= Context)
+        {
+            auto it = byContext.find(context(data, position));
+            if (it != byContext.end())
+                return it->second;
+        }
+        return common;
+    }
+
+    /**
+     * Состояние после чтения data[0, n) из начального состояния.
+     *
+     * @param threads Число потоков (0 — по числу ядер).
+     * @param stats   Если задан, заполняется счётчиками запуска.
+     */
+    std::uint32_t run(const char *data, size_t n, size_t threads = 0, SpeculationStats *stats = nullptr) const
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t chunks = std::max<size_t>(1, std::min(threads, n / Checkpoint));
+
+        std::vector<std::uint32_t> entry(chunks), exit(chunks);
+        std::vector<std::vector<std::uint32_t>> marks(chunks); // Состояния в контрольных точках угаданного пути
+        auto bounds = [&](size_t t)
+        { return std::make_pair(n * t / chunks, n * (t + 1) / chunks); };
+
+        auto work = [&](size_t t)
+        {
+            auto [begin, end] = bounds(t);
+            std::uint32_t state = t == 0 ? engine.initial() : guess(data, begin);
+            entry[t] = state;
+            for (size_t p = begin; p < end; p += Checkpoint)
+            {
+                state = engine.run(state, data + p, std::min(Checkpoint, end - p));
+                marks[t].push_back(state);
+            }
+            exit[t] = state;
+        };
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < chunks; ++t)
+            workers.emplace_back(work, t);
+        work(0);
+        for (auto &worker : workers)
+            worker.join();
+
+        SpeculationStats local;
+        local.chunks = chunks;
+        std::uint32_t actual = exit[0];
+        for (size_t t = 1; t < chunks; ++t)
+        {
+            if (entry[t] == actual)
+            {
+                actual = exit[t];
+                continue;
+            }
+            // Исправление: перечитываем, пока путь не сольётся с угаданным
+            local.mispredicted++;
+            auto [begin, end] = bounds(t);
+            std::uint32_t state = actual;
+            size_t k = 0;
+            for (size_t p = begin; p < end; p += Checkpoint, ++k)
+            {
+                size_t length = std::min(Checkpoint, end - p);
+                state = engine.run(state, data + p, length);
+                local.rescanned += length;
+                if (state == marks[t][k])
+                {
+                    state = exit[t];
+                    break;
+                }
+            }
+            actual = state;
+        }
+        if (stats)
+            *stats = local;
+        return actual;
+    }
+
+    bool accepts(std::uint32_t state) const { return engine.accepts(state); }
+
+    bool accepts(const char *data, size_t n, size_t threads = 0) const { return engine.accepts(run(data, n, threads)); }
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+#include "dfa.hpp"
+
+/**
+ * Табличный распознаватель, читающий за один переход сразу stride байтов.
+ *
+ * Сначала алфавит сжимается до классов байтов, неразличимых автоматом
+ * (для автоматов lab1 это {0, 1, прочие}). Тогда группа из stride байтов —
+ * число в системе счисления по основанию k (k — число классов), и таблица
+ * переходов по группам занимает states × k^stride элементов. Цифры группы
+ * берутся из независимых таблиц classDigit, так что на цепочке зависимостей
+ * остаётся одно чтение таблицы на stride байтов вместо одного на байт.
+ * Остаток входа короче stride дочитывается по одному байту.
+ */
+class StrideDfa
+{
+    size_t stride = 1;
+    std::uint32_t classes = 0;
+    std::uint32_t row = 0;                         // Элементов в строке таблицы: k^stride
+    std::vector<std::array<std::uint32_t, 256>> classDigit; // classDigit[i][byte] = класс * k^i
+    std::vector<std::uint32_t> table;              // Следующее состояние, умноженное на row
+    std::vector<std::uint32_t> single;             // Переход по одному классу: states × k, тоже умножено на row
+    std::vector<bool> accepting;
+    std::uint32_t start = 0;
+
+public:
+    /// Кэш, в который должна помещаться таблица при автоматическом выборе шага.
+    static constexpr size_t L1 = 32 << 10, L2 = 256 << 10;
+    /// Предел таблицы при явно заданном шаге; смещения в ней 32-битные.
+    static constexpr size_t MaxTableBytes = size_t(1) << 30;
+
+    /**
+     * @param stride Число байтов на переход; 0 — наибольшая степень двойки (до 8),
+     *               при которой таблица занимает не больше cacheBudget байтов.
+     * @throws std::invalid_argument если при заданном шаге таблица больше MaxTableBytes.
+     */
+    explicit StrideDfa(const Dfa &dfa, size_t stride = 0, size_t cacheBudget = L1)
+        : accepting(dfa.accepting), start(dfa.start)
+    {
+        // Сжатие алфавита: байты с одинаковыми столбцами переходов — один класс
+        std::map<std::vector<std::uint32_t>, std::uint32_t> columns;
+        std::array<std::uint32_t, 256> classOf;
+        for (int c = 0; c < 256; ++c)
+        {
+            std::vector<std::uint32_t> column(dfa.size());
+            for (size_t s = 0; s < dfa.size(); ++s)
+                column[s] = dfa.next[s][c];
+            auto it = columns.emplace(column, static_cast<std::uint32_t>(columns.size())).first;
+            classOf[c] = it->second;
+        }
+        classes = static_cast<std::uint32_t>(columns.size());
+        std::vector<int> representative(classes);
+        for (int c = 255; c >= 0; --c)
+            representative[classOf[c]] = c;
+
+        if (stride == 0)
+            stride = chooseStride(dfa.size(), classes, cacheBudget);
+        else if (tableSize(dfa.size(), classes, stride) > MaxTableBytes)
+            throw std::invalid_argument("StrideDfa: таблица для шага " + std::to_string(stride) + " слишком велика");
+        this->stride = stride;
+        row = 1;
+        for (size_t i = 0; i < stride; ++i)
+            row *= classes;
+
+        classDigit.resize(stride);
+        for (size_t i = 0, weight = 1; i < stride; ++i, weight *= classes)
+        {
+            for (int c = 0; c < 256; ++c)
+                classDigit[i][c] = classOf[c] * static_cast<std::uint32_t>(weight);
+        }
+
+        single.resize(dfa.size() * classes);
+        for (size_t s = 0; s < dfa.size(); ++s)
+        {
+            for (std::uint32_t k = 0; k < classes; ++k)
+                single[s * classes + k] = dfa.next[s][representative[k]] * row;
+        }
+
+        // Переход по группе: младшая цифра — первый байт группы
+        table.resize(dfa.size() * row);
+        for (size_t s = 0; s < dfa.size(); ++s)
+        {
+            for (std::uint32_t group = 0; group < row; ++group)
+            {
+                std::uint32_t state = static_cast<std::uint32_t>(s);
+                for (std::uint32_t rest = group, i = 0; i < stride; ++i, rest /= classes)
+                    state = dfa.next[state][representative[rest % classes]];
+                table[s * row + group] = state * row;
+            }
+        }
+    }
+
+    /// Байтов в таблице states × classes^stride; SIZE_MAX, если произведение переполняется.
+    static size_t tableSize(size_t states, size_t classes, size_t stride)
+    {
+        size_t entries = states;
+        for (size_t i = 0; i < stride; ++i)
+        {
+            if (classes != 0 && entries > SIZE_MAX / sizeof(std::uint32_t) / classes)
+                return SIZE_MAX;
+            entries *= classes;
+        }
+        return entries * sizeof(std::uint32_t);
+    }
+
+    /// Наибольший шаг из 1, 2, 4, 8, при котором таблица не больше budget байтов.
+    static size_t chooseStride(size_t states, size_t classes, size_t budget)
+    {
+        size_t best = 1;
+        for (size_t stride = 2; stride <= 8; stride *= 2)
+        {
+            if (tableSize(states, classes, stride) > std::min(budget, MaxTableBytes))
+                break;
+            best = stride;
+        }
+        return best;
+    }
+
+    size_t step() const { return stride; }
+    std::uint32_t alphabet() const { return classes; }
+    size_t tableBytes() const { return table.size() * sizeof(std::uint32_t); }
+
+    std::uint32_t initial() const { return start; }
+    bool accepts(std::uint32_t state) const { return accepting[state]; }
+
+    /// Состояние после чтения data[0, n) из состояния state.
+    std::uint32_t run(std::uint32_t state, const char *data, size_t n) const
+    {
+        const auto *p = reinterpret_cast<const unsigned char *>(data);
+        const std::uint32_t *t = table.data();
+        std::uint32_t offset = state * row;
+        size_t i = 0;
+        switch (stride)
+        {
+        case 8:
+            for (; i + 8 <= n; i += 8)
+            {
+                offset = t[offset + classDigit[0][p[i]] + classDigit[1][p[i + 1]] + classDigit[2][p[i + 2]] +
+                           classDigit[3][p[i + 3]] + classDigit[4][p[i + 4]] + classDigit[5][p[i + 5]] +
+                           classDigit[6][p[i + 6]] + classDigit[7][p[i + 7]]];
+            }
+            break;
+        case 4:
+            for (; i + 4 <= n; i += 4)
+            {
+                offset = t[offset + classDigit[0][p[i]] + classDigit[1][p[i + 1]] + classDigit[2][p[i + 2]] +
+                           classDigit[3][p[i + 3]]];
+            }
+            break;
+        case 2:
+            for (; i + 2 <= n; i += 2)
+                offset = t[offset + classDigit[0][p[i]] + classDigit[1][p[i + 1]]];
+            break;
+        default:
+            for (; i + stride <= n; i += stride)
+            {
+                std::uint32_t group = 0;
+                for (size_t j = 0; j < stride; ++j)
+                    group += classDigit[j][p[i + j]];
+                offset = t[offset + group];
+            }
+        }
+        // Остаток короче шага
+        for (; i < n; ++i)
+            offset = single[offset / row * classes + classDigit[0][p[i]]];
+        return offset / row;
+    }
+
+    bool accepts(const char *data, size_t n) const { return accepting[run(start, data, n)]; }
+};
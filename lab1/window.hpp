@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string_view>
+
+/**
+ * Свойство dfaOddConsecutive на скользящем окне из последних W бит потока.
+ *
+ * Окно хранится как очередь серий; первая серия может быть обрезана началом окна,
+ * последняя ещё растёт. Для завершённых серий между ними держится по монотонной
+ * очереди на символ (длины убывают от начала к концу), так что максимум серий
+ * каждого символа в окне — это голова очереди, обрезанная первая серия или
+ * текущая последняя. Каждый бит обрабатывается за амортизированное O(1).
+ *
+ * Символы, отличные от '0' и '1' (например, переводы строк между порциями),
+ * пропускаются так же, как при фильтрации входа в main.
+ */
+class OddRunWindow
+{
+    struct Run
+    {
+        std::uint64_t id;
+        char symbol;
+        std::uint64_t start; // Номер первого бита серии в потоке
+        std::uint64_t length;
+    };
+
+    std::uint64_t width;
+    std::uint64_t total = 0;  // Сколько бит получено
+    std::uint64_t nextId = 0;
+    std::deque<Run> runs;     // Серии, пересекающиеся с окном
+    std::deque<Run> best[2];  // Монотонные очереди завершённых серий нулей и единиц
+    bool current = false;     // Значение свойства на текущем окне
+
+    /// Максимальная длина серии символа s в окне.
+    std::uint64_t maxRun(int s) const
+    {
+        std::uint64_t windowStart = total > width ? total - width : 0;
+        const Run &front = runs.front();
+        std::uint64_t result = 0;
+        if (front.symbol - '0' == s)
+            result = front.start + front.length - std::max(front.start, windowStart);
+        if (runs.size() > 1 && runs.back().symbol - '0' == s)
+            result = std::max(result, runs.back().length);
+        if (!best[s].empty())
+            result = std::max(result, best[s].front().length);
+        return result;
+    }
+
+    void push(char c)
+    {
+        total++;
+        if (!runs.empty() && runs.back().symbol == c)
+        {
+            runs.back().length++;
+        }
+        else
+        {
+            if (runs.size() > 1)
+            {
+                // Последняя серия завершилась и она не первая — в монотонную очередь
+                const Run &done = runs.back();
+                auto &queue = best[done.symbol - '0'];
+                while (!queue.empty() && queue.back().length <= done.length)
+                    queue.pop_back();
+                queue.push_back(done);
+            }
+            runs.push_back({nextId++, c, total - 1, 1});
+        }
+
+        // Серии, целиком вышедшие из окна, удаляются; новая первая серия
+        // покидает монотонную очередь, так как теперь может быть обрезана
+        std::uint64_t windowStart = total > width ? total - width : 0;
+        while (runs.front().start + runs.front().length <= windowStart)
+        {
+            runs.pop_front();
+            auto &queue = best[runs.front().symbol - '0'];
+            if (!queue.empty() && queue.front().id == runs.front().id)
+                queue.pop_front();
+        }
+    }
+
+public:
+    explicit OddRunWindow(std::uint64_t w) : width(std::max<std::uint64_t>(w, 1)) {}
+
+    /// Значение свойства на текущем окне (false, пока не получено ни одного бита).
+    bool value() const { return current; }
+
+    /// Сколько бит получено.
+    std::uint64_t position() const { return total; }
+
+    /**
+     * Добавляет порцию потока.
+     *
+     * @param onChange Вызывается как onChange(position, value) при каждом изменении
+     *                 свойства; position — число бит, полученных к этому моменту.
+     */
+    template <typename Callback>
+    void feed(std::string_view chunk, Callback onChange)
+    {
+        for (char c : chunk)
+        {
+            if (c != '0' && c != '1')
+                continue;
+            push(c);
+            bool now = (maxRun(0) % 2 == 1) && (maxRun(1) % 2 == 1);
+            if (now != current)
+            {
+                current = now;
+                onChange(total, now);
+            }
+        }
+    }
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define ARENA_LINUX 1
+#endif
+
+/// Как выделять память под большие буферы разбора (токены, узлы AST).
+struct MemoryPolicy {
+    /// Размер страниц: обычные; прозрачные большие страницы (madvise(MADV_HUGEPAGE));
+    /// явные большие страницы (MAP_HUGETLB) с откатом на прозрачные, если пул пуст.
+    enum class Pages { Normal, Transparent, Explicit };
+    static constexpr int AnyNode = -1;   ///< Не привязывать память к узлу NUMA.
+    static constexpr int LocalNode = -2; ///< Узел потока, создавшего арену.
+
+    Pages pages = Pages::Transparent;
+    int node = AnyNode; ///< Номер узла NUMA для mbind или AnyNode / LocalNode.
+};
+
+/// Узел NUMA, на котором сейчас выполняется поток (0, если узнать нельзя).
+inline int currentNumaNode() {
+#ifdef ARENA_LINUX
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return static_cast<int>(node);
+#endif
+    return 0;
+}
+
+/// Арена для многогигабайтных разборов: память берётся у ОС блоками, кратными
+/// большой странице (2 МиБ), и выдаётся сдвигом указателя. Блоки выровнены по
+/// 2 МиБ, так что ядро может отобразить их большими страницами целиком и
+/// массив токенов и узлы AST занимают в TLB в сотни раз меньше записей.
+/// При заданном узле NUMA блоки привязываются к нему (mbind) до первого
+/// касания. Освобождение отдельных объектов ничего не делает — память
+/// возвращается целиком при разрушении арены или release(), поэтому арена
+/// должна жить дольше всех выделенных из неё объектов (и старые буферы
+/// растущего вектора остаются в ней до release()). Не потокобезопасна:
+/// у каждого рабочего потока своя арена (workerArena()).
+class HugePageArena : public std::pmr::memory_resource {
+public:
+    static constexpr std::size_t HugePage = std::size_t(2) << 20;
+
+    /// Счётчики выделений.
+    struct Stats {
+        std::size_t blocks = 0;   ///< Блоков, полученных у ОС.
+        std::size_t explicitHuge = 0; ///< Из них на явных больших страницах.
+        std::size_t advised = 0;  ///< Из них помеченных madvise(MADV_HUGEPAGE).
+        std::size_t bound = 0;    ///< Из них привязанных к узлу NUMA.
+        std::size_t mapped = 0;   ///< Байтов получено у ОС.
+        std::size_t used = 0;     ///< Байтов выдано (с учётом выравнивания).
+    };
+
+private:
+    struct Block {
+        void* base;
+        std::size_t size;
+    };
+
+    MemoryPolicy policy;
+    int boundNode;
+    std::size_t blockSize;
+    std::vector<Block> blocks;
+    std::size_t current = 0; ///< Блок, из которого сейчас идёт выдача.
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    Stats counters;
+
+    static std::size_t roundUp(std::size_t n, std::size_t to) { return (n + to - 1) / to * to; }
+
+    void* map(std::size_t size) {
+#ifdef ARENA_LINUX
+        void* p = MAP_FAILED;
+        if (policy.pages == MemoryPolicy::Pages::Explicit) {
+            p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            counters.explicitHuge += p != MAP_FAILED;
+        }
+        if (p == MAP_FAILED) {
+            // Берём с запасом в одну большую страницу и обрезаем до выровненного куска
+            std::size_t padded = size + HugePage;
+            char* raw = static_cast<char*>(mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (raw == MAP_FAILED) throw std::bad_alloc();
+            char* aligned = raw + (HugePage - reinterpret_cast<std::uintptr_t>(raw) % HugePage) % HugePage;
+            if (aligned > raw) munmap(raw, aligned - raw);
+            if (raw + padded > aligned + size) munmap(aligned + size, raw + padded - (aligned + size));
+            p = aligned;
+            if (policy.pages != MemoryPolicy::Pages::Normal && madvise(p, size, MADV_HUGEPAGE) == 0)
+                counters.advised++;
+        }
+        if (boundNode >= 0 && boundNode < 64) {
+            unsigned long mask = 1UL << boundNode;
+            if (syscall(SYS_mbind, p, size, MPOL_BIND, &mask, sizeof(mask) * 8 + 1, 0) == 0) counters.bound++;
+        }
+        return p;
+#else
+        return ::operator new(size, std::align_val_t(HugePage));
+#endif
+    }
+
+    void unmap(const Block& block) {
+#ifdef ARENA_LINUX
+        munmap(block.base, block.size);
+#else
+        ::operator delete(block.base, std::align_val_t(HugePage));
+#endif
+    }
+
+    void use(std::size_t index) {
+        current = index;
+        cursor = static_cast<char*>(blocks[index].base);
+        limit = cursor + blocks[index].size;
+    }
+
+    void grow(std::size_t bytes, std::size_t alignment) {
+        // После release() сначала идут уже полученные блоки, достаточно большие
+        for (std::size_t next = cursor ? current + 1 : 0; next < blocks.size(); ++next)
+            if (blocks[next].size >= bytes + alignment) {
+                use(next);
+                return;
+            }
+        std::size_t size = roundUp(std::max(blockSize, bytes + alignment), HugePage);
+        void* base = map(size);
+        blocks.push_back({base, size});
+        use(blocks.size() - 1);
+        counters.blocks++;
+        counters.mapped += size;
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        for (;;) {
+            auto address = reinterpret_cast<std::uintptr_t>(cursor);
+            char* start = cursor + (alignment - address % alignment) % alignment;
+            if (cursor && start + bytes <= limit) {
+                counters.used += start + bytes - cursor;
+                cursor = start + bytes;
+                return start;
+            }
+            grow(bytes, alignment);
+        }
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+    /// @param blockSize Размер блока, запрашиваемого у ОС (округляется до 2 МиБ).
+    explicit HugePageArena(MemoryPolicy p = {}, std::size_t blockSize = 16 * HugePage)
+        : policy(p), boundNode(p.node == MemoryPolicy::LocalNode ? currentNumaNode() : p.node),
+          blockSize(roundUp(blockSize, HugePage)) {}
+
+    HugePageArena(const HugePageArena&) = delete;
+    HugePageArena& operator=(const HugePageArena&) = delete;
+
+    ~HugePageArena() override {
+        for (const Block& block : blocks) unmap(block);
+    }
+
+    /// Делает всю память арены снова свободной, не возвращая блоки ОС: следующие
+    /// выделения идут с начала первого блока. Все объекты, выделенные из арены,
+    /// к этому моменту должны быть разрушены.
+    void release() {
+        cursor = limit = nullptr;
+        current = 0;
+        counters.used = 0;
+    }
+
+    /// Узел NUMA, к которому привязываются блоки (AnyNode, если не привязываются).
+    int node() const { return boundNode; }
+
+    const Stats& stats() const { return counters; }
+};
+
+/// Арена текущего потока, привязанная к узлу NUMA, на котором поток её создал.
+/// Рабочие потоки пакетного разбора берут отсюда память под токены и узлы AST,
+/// и она оказывается на их же узле, а не на узле главного потока. Арена живёт
+/// до завершения потока; чтобы она не росла в долгоживущем пуле, каждое
+/// задание выполняется внутри ArenaJob.
+inline HugePageArena& workerArena() {
+    thread_local HugePageArena arena({MemoryPolicy::Pages::Transparent, MemoryPolicy::LocalNode});
+    return arena;
+}
+
+/// Одно задание рабочего потока: выдаёт арену потока, а по окончании
+/// задания освобождает её (release()), и следующее задание получает те же
+/// блоки. Результаты задания из арены не должны его переживать. Задания могут
+/// быть вложенными (например, вспомогательная функция открывает своё задание
+/// внутри чужого): арена освобождается только с окончанием внешнего задания,
+/// и всё выделенное во вложенном живёт до тех пор.
+class ArenaJob {
+    HugePageArena& arena;
+
+    static std::size_t& depth() {
+        thread_local std::size_t open = 0;
+        return open;
+    }
+
+public:
+    ArenaJob() : arena(workerArena()) { depth()++; }
+    ArenaJob(const ArenaJob&) = delete;
+    ArenaJob& operator=(const ArenaJob&) = delete;
+    ~ArenaJob() {
+        if (--depth() == 0) arena.release();
+    }
+
+    HugePageArena& memory() const { return arena; }
+};
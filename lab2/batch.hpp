@@ -0,0 +1,165 @@
+#pragma once
+
+#include "vm.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WHILE_BATCH_AVX2 1
+#endif
+
+/// Набор окружений для пакетного выполнения: значения int32 хранятся блоками
+/// по 8 окружений (дорожек), внутри блока — по переменным:
+/// data[(block * vars + var) * 8 + lane % 8]. Так один регистр AVX2 содержит
+/// одну переменную восьми окружений, а все переменные блока лежат рядом.
+class BatchEnv {
+    size_t laneCount, varCount;
+    std::vector<std::int32_t> data;
+    std::vector<std::uint8_t> divergedLanes;
+
+public:
+    static constexpr size_t Width = 8;
+
+    BatchEnv(size_t lanes, size_t vars)
+        : laneCount(lanes), varCount(vars), data((lanes + Width - 1) / Width * vars * Width, 0),
+          divergedLanes(lanes, 0) {}
+
+    size_t lanes() const { return laneCount; }
+    size_t vars() const { return varCount; }
+    size_t blocks() const { return (laneCount + Width - 1) / Width; }
+
+    std::int32_t& at(size_t lane, size_t var) { return data[(lane / Width * varCount + var) * Width + lane % Width]; }
+    std::int32_t at(size_t lane, size_t var) const { return data[(lane / Width * varCount + var) * Width + lane % Width]; }
+
+    /// Значения переменных блока из 8 дорожек.
+    std::int32_t* block(size_t b) { return data.data() + b * varCount * Width; }
+
+    /// true, если программа в этом окружении не завершается.
+    bool diverged(size_t lane) const { return divergedLanes[lane]; }
+    std::uint8_t* divergedBlock(size_t b) { return divergedLanes.data() + b * Width; }
+};
+
+/// Одна программа, выполняемая сразу над многими окружениями.
+///
+/// Циклы переводятся в замкнутую форму (см. TripCount), поэтому ветвление
+/// по дорожкам сводится к маскам: m = условие; x = m ? e : x; дорожки, где
+/// условие осталось истинным, помечаются как зациклившиеся и дальше не
+/// изменяются. Векторный путь использует AVX2 (8 значений int32 за команду),
+/// при его отсутствии выполняется скалярный цикл по дорожкам.
+class BatchProgram {
+    struct Step {
+        bool lhsVar, rhsVar, valueVar;
+        std::int32_t lhs, rhs, value;
+        char rel;
+        std::uint32_t target;
+    };
+
+    VarTable table;
+    std::vector<Step> steps;
+
+    static bool compare(std::int32_t l, char rel, std::int32_t r) {
+        return rel == '<' ? l < r : rel == '>' ? l > r : l == r;
+    }
+
+    void runScalarBlock(std::int32_t* vars, std::uint8_t* diverged, size_t width) const {
+        for (size_t lane = 0; lane < width; ++lane) {
+            auto get = [&](bool variable, std::int32_t v) { return variable ? vars[v * BatchEnv::Width + lane] : v; };
+            diverged[lane] = 0;
+            for (const Step& s : steps) {
+                if (!compare(get(s.lhsVar, s.lhs), s.rel, get(s.rhsVar, s.rhs))) continue;
+                vars[s.target * BatchEnv::Width + lane] = get(s.valueVar, s.value);
+                if (compare(get(s.lhsVar, s.lhs), s.rel, get(s.rhsVar, s.rhs))) {
+                    diverged[lane] = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+#ifdef WHILE_BATCH_AVX2
+    __attribute__((target("avx2"))) static __m256i load(const std::int32_t* vars, bool variable, std::int32_t v) {
+        return variable ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vars + v * BatchEnv::Width))
+                        : _mm256_set1_epi32(v);
+    }
+
+    __attribute__((target("avx2"))) static __m256i compare(__m256i l, char rel, __m256i r) {
+        return rel == '<' ? _mm256_cmpgt_epi32(r, l) : rel == '>' ? _mm256_cmpgt_epi32(l, r) : _mm256_cmpeq_epi32(l, r);
+    }
+
+    __attribute__((target("avx2"))) void runAvx2Block(std::int32_t* vars, std::uint8_t* diverged) const {
+        __m256i active = _mm256_set1_epi32(-1);
+        __m256i stuck = _mm256_setzero_si256();
+        for (const Step& s : steps) {
+            __m256i taken = _mm256_and_si256(active, compare(load(vars, s.lhsVar, s.lhs), s.rel, load(vars, s.rhsVar, s.rhs)));
+            if (_mm256_testz_si256(taken, taken)) continue;
+
+            auto* target = reinterpret_cast<__m256i*>(vars + s.target * BatchEnv::Width);
+            __m256i value = load(vars, s.valueVar, s.value);
+            _mm256_storeu_si256(target, _mm256_blendv_epi8(_mm256_loadu_si256(target), value, taken));
+
+            __m256i again = _mm256_and_si256(taken, compare(load(vars, s.lhsVar, s.lhs), s.rel, load(vars, s.rhsVar, s.rhs)));
+            stuck = _mm256_or_si256(stuck, again);
+            active = _mm256_andnot_si256(again, active);
+            if (_mm256_testz_si256(active, active)) break;
+        }
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(stuck));
+        for (size_t lane = 0; lane < BatchEnv::Width; ++lane) diverged[lane] = mask >> lane & 1;
+    }
+#endif
+
+public:
+    /// Компилирует AST программы. Константы усекаются до диапазона int32.
+    static BatchProgram compile(const std::shared_ptr<ASTNode>& program) {
+        BatchProgram p;
+        for (const auto& loop : program->children[0]->children) {
+            const auto& cond = loop->children[0];
+            const auto& body = loop->children[1];
+            auto operand = [&](const std::shared_ptr<ASTNode>& node, bool& variable, std::int32_t& value) {
+                variable = node->type != "RomanNumeral";
+                value = variable ? static_cast<std::int32_t>(p.table.intern(node->value))
+                                 : static_cast<std::int32_t>(std::min(romanToInt(node->value), INT32_MAX));
+            };
+            Step step;
+            operand(cond->children[0], step.lhsVar, step.lhs);
+            operand(cond->children[2], step.rhsVar, step.rhs);
+            step.rel = cond->children[1]->value[0];
+            step.target = p.table.intern(body->children[0]->value);
+            operand(body->children[1], step.valueVar, step.value);
+            p.steps.push_back(step);
+        }
+        return p;
+    }
+
+    const VarTable& vars() const { return table; }
+
+    /// true, если процессор поддерживает векторный путь.
+    static bool vectorized() {
+#ifdef WHILE_BATCH_AVX2
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    /// Выполняет программу во всех окружениях env.
+    /// allowVector = false принудительно включает скалярный путь.
+    /// @throws std::invalid_argument если в env меньше переменных, чем в программе.
+    void run(BatchEnv& env, bool allowVector = true) const {
+        if (env.vars() < table.size())
+            throw std::invalid_argument("в окружении " + std::to_string(env.vars()) + " переменных, программе нужно " +
+                                        std::to_string(table.size()));
+        bool vector = allowVector && vectorized();
+        (void)vector;
+        for (size_t b = 0; b < env.blocks(); ++b) {
+            size_t width = std::min(BatchEnv::Width, env.lanes() - b * BatchEnv::Width);
+#ifdef WHILE_BATCH_AVX2
+            if (vector && width == BatchEnv::Width) {
+                runAvx2Block(env.block(b), env.divergedBlock(b));
+                continue;
+            }
+#endif
+            runScalarBlock(env.block(b), env.divergedBlock(b), width);
+        }
+    }
+};
@@ -0,0 +1,389 @@
+#include "main.hpp"
+#include "diff.hpp"
+#include "tokstream.hpp"
+#include "vm.hpp"
+#include "jit.hpp"
+#include "parallel.hpp"
+#include "batch.hpp"
+#include "arena.hpp"
+
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <thread>
+
+/// Секундомер для замеров.
+struct Stopwatch
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+/// Генерирует программу из n циклов со случайными переменными и числами.
+std::string generateProgram(size_t n, unsigned seed = 42)
+{
+    std::mt19937 rng(seed);
+    auto name = [&]
+    { return "v" + std::to_string(rng() % 1000); };
+    auto expr = [&]
+    { return rng() % 2 ? name() : intToRoman(1 + rng() % 39); };
+    static const char *ops[] = {"<", ">", "="};
+
+    std::string program;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i)
+            program += "; ";
+        program += "while (" + name() + " " + ops[rng() % 3] + " " + expr() + ") " + name() + " := " + expr() + " done";
+    }
+    return program;
+}
+
+/// Сжатие потока токенов: коэффициент и скорость декодирования.
+void benchTokenStream()
+{
+    std::cout << "=== Сжатый поток токенов ===\n";
+    std::string program = generateProgram(200000);
+    auto tokens = tokenize(program);
+
+    size_t tokenBytes = tokens.size() * sizeof(Token);
+    for (const auto &token : tokens)
+        if (token.value.capacity() > 15)
+            tokenBytes += token.value.capacity() + 1;
+    std::string encoded = TokenStreamEncoder::encode(tokens);
+
+    std::cout << "Токенов: " << tokens.size() << ", текст: " << program.size() << " байт, Token[]: "
+              << tokenBytes << " байт, поток: " << encoded.size() << " байт\n";
+    std::cout << "Сжатие: " << double(tokenBytes) / encoded.size() << "x относительно Token[], "
+              << double(program.size()) / encoded.size() << "x относительно текста\n";
+
+    const int rounds = 10;
+    size_t count = 0;
+    Stopwatch decode;
+    for (int r = 0; r < rounds; ++r)
+    {
+        TokenStreamDecoder decoder(encoded);
+        while (decoder.next().type != TokenType::END)
+            count++;
+    }
+    double t = decode.seconds();
+    std::cout << "Декодирование: " << rounds * encoded.size() / t / 1e9 << " ГБ/с сжатого потока, "
+              << count / t / 1e6 << " млн токенов/с\n";
+
+    Stopwatch parseStream;
+    TokenStreamDecoder decoder(encoded);
+    LRParser(decoder).parse();
+    double streamed = parseStream.seconds();
+    Stopwatch parseText;
+    LRParser(tokenize(program)).parse();
+    std::cout << "Разбор из потока: " << streamed * 1e3 << " мс, токенизация и разбор текста: "
+              << parseText.seconds() * 1e3 << " мс\n\n";
+}
+
+/// Лексер по таблицам ДКА: скорость scanToken без построения токенов.
+void benchLexer()
+{
+    std::cout << "=== Лексер ===\n";
+    std::string program = generateProgram(1000000);
+    size_t tokens = 0;
+    Stopwatch timer;
+    for (size_t i = 0; i < program.size();)
+    {
+        if (isSpaceChar(program[i]))
+        {
+            i++;
+            continue;
+        }
+        i += scanToken(program, i).length;
+        tokens++;
+    }
+    double t = timer.seconds();
+    std::cout << "scanToken: " << program.size() / t / 1e9 << " ГБ/с, " << tokens / t / 1e6 << " млн токенов/с\n";
+
+    // Проверка UTF-8 перед лексером: ASCII-вход и вход с кириллическими именами
+    std::string cyrillic;
+    for (char c : program)
+        cyrillic += c == 'v' ? std::string("ж") : std::string(1, c);
+    for (const std::string* text : {&program, &cyrillic})
+    {
+        Stopwatch check;
+        Utf8Check result = checkUtf8(*text);
+        double seconds = check.seconds();
+        std::cout << "checkUtf8 (" << (result.ascii ? "ASCII" : "кириллица") << "): " << text->size() / seconds / 1e9
+                  << " ГБ/с" << (result.error == std::string_view::npos ? "" : ", ошибка") << "\n";
+    }
+    std::cout << "\n";
+}
+
+/// Индекс строк: построение по запросу и перевод смещений в строку и столбец.
+void benchLineIndex()
+{
+    std::cout << "=== Индекс строк ===\n";
+    std::string program = generateProgram(1000000);
+    for (size_t i = 0; i + 1 < program.size(); ++i)
+        if (program[i] == ';')
+            program[i + 1] = '\n';
+
+    Stopwatch build;
+    LineIndex lines(program);
+    size_t count = lines.lines();
+    double t = build.seconds();
+    std::cout << "Построение: " << program.size() / t / 1e9 << " ГБ/с, строк " << count << "\n";
+
+    std::mt19937 rng(5);
+    const size_t queries = 1000000;
+    size_t checksum = 0;
+    Stopwatch locate;
+    for (size_t q = 0; q < queries; ++q)
+        checksum += lines.locate(rng() % program.size()).line;
+    std::cout << "Запросы: " << queries / locate.seconds() / 1e6 << " млн/с (" << checksum % 10 << ")\n\n";
+}
+
+/// Токены и AST в обычной куче и в арене на больших страницах.
+void benchArena()
+{
+    std::cout << "=== Арена на больших страницах ===\n";
+    std::string program = generateProgram(1000000);
+
+    Stopwatch heap;
+    {
+        auto tokens = tokenize(program);
+        LRParser(std::move(tokens)).parse();
+    }
+    double heapTime = heap.seconds();
+
+    Stopwatch huge;
+    {
+        HugePageArena arena({MemoryPolicy::Pages::Transparent, MemoryPolicy::LocalNode});
+        auto tokens = tokenize(program, &arena);
+        LRParser(std::move(tokens), std::make_shared<ASTFactory>(&arena)).parse();
+        std::cout << "Арена: " << arena.stats().mapped / (1 << 20) << " МиБ, блоков " << arena.stats().blocks
+                  << ", madvise " << arena.stats().advised << ", узел " << arena.node() << "\n";
+    }
+    double hugeTime = huge.seconds();
+    std::cout << "Токенизация и разбор: куча " << heapTime * 1e3 << " мс, арена " << hugeTime * 1e3 << " мс\n";
+
+    // Рабочие потоки: каждое задание в арене своего потока на своём узле NUMA,
+    // после задания арена освобождается, и следующее берёт те же блоки
+    const size_t threads = 4, jobs = 3;
+    std::string chunk = generateProgram(100000);
+    std::vector<size_t> mapped(threads), grown(threads);
+    std::vector<int> local(threads);
+    std::vector<std::thread> workers;
+    auto work = [&](size_t t)
+    {
+        for (size_t job = 0; job < jobs; ++job)
+        {
+            ArenaJob scope;
+            LRParser(tokenize(chunk, &scope.memory()), std::make_shared<ASTFactory>(&scope.memory())).parse();
+            size_t now = scope.memory().stats().mapped;
+            grown[t] += job > 0 && now > mapped[t];
+            mapped[t] = now;
+        }
+        local[t] = workerArena().node() == currentNumaNode();
+    };
+    Stopwatch pool;
+    for (size_t t = 0; t < threads; ++t)
+        workers.emplace_back(work, t);
+    for (auto &worker : workers)
+        worker.join();
+    std::cout << "Потоки: " << threads << " × " << jobs << " заданий за " << pool.seconds() * 1e3
+              << " мс, арена потока " << mapped[0] / (1 << 20) << " МиБ, росла после первого задания: "
+              << std::accumulate(grown.begin(), grown.end(), size_t(0)) << " раз, арены на своих узлах: "
+              << std::accumulate(local.begin(), local.end(), 0) << " из " << threads << "\n\n";
+}
+
+/// Дифф двух версий большой программы: вставка у начала, удаление у конца.
+void benchDiff()
+{
+    std::cout << "=== Сравнение версий ===\n";
+    std::string before = generateProgram(100000), after = before;
+    after.insert(after.find(';') + 1, " while (z = I) z := II done;");
+    after.erase(after.rfind(';'));
+    auto oldAst = LRParser(tokenize(before)).parse();
+    auto newAst = LRParser(tokenize(after)).parse();
+
+    Stopwatch timer;
+    auto diff = ASTDiff::run(oldAst, newAst);
+    double t = timer.seconds();
+    std::cout << "Различий: " << diff.size() << ", время " << t * 1e3 << " мс\n\n";
+}
+
+/// Генерирует завершающуюся программу из n циклов типовых форм:
+/// каждый цикл выполняется не более одного раза.
+std::string generateTerminatingProgram(size_t n, size_t vars = 64, unsigned seed = 7)
+{
+    std::mt19937 rng(seed);
+    auto name = [&]
+    { return "v" + std::to_string(rng() % vars); };
+
+    std::string program;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i)
+            program += "; ";
+        std::string v = name(), w = name();
+        int c = 1 + rng() % 20;
+        switch (rng() % 4)
+        {
+        case 0: // v < c  ->  v := c
+            program += "while (" + v + " < " + intToRoman(c) + ") " + v + " := " + intToRoman(c + rng() % 10) + " done";
+            break;
+        case 1: // v > c  ->  v := c
+            program += "while (" + v + " > " + intToRoman(c) + ") " + v + " := " + intToRoman(c) + " done";
+            break;
+        case 2: // v = c  ->  v := c + 1
+            program += "while (" + v + " = " + intToRoman(c) + ") " + v + " := " + intToRoman(c + 1) + " done";
+            break;
+        default: // v < w  ->  v := w
+            program += "while (" + v + " < " + w + ") " + v + " := " + w + " done";
+            break;
+        }
+    }
+    return program;
+}
+
+/// Обычный байткод против суперкоманд: число диспетчеризаций и пропускная способность.
+void benchVM()
+{
+    std::cout << "=== Виртуальная машина ===\n";
+    const size_t loops = 100000;
+    auto ast = LRParser(tokenize(generateTerminatingProgram(loops))).parse();
+
+    for (CompileMode mode : {CompileMode::Plain, CompileMode::Super})
+    {
+        Bytecode program = Compiler::compile(ast, mode);
+        const int rounds = 50;
+        std::uint64_t dispatches = 0;
+        std::mt19937 rng(1);
+        Stopwatch timer;
+        for (int r = 0; r < rounds; ++r)
+        {
+            std::vector<std::int64_t> env(program.vars.size());
+            for (auto &v : env)
+                v = rng() % 30;
+            dispatches += execute(program, env).dispatches;
+        }
+        double t = timer.seconds();
+        std::cout << (mode == CompileMode::Plain ? "Обычный байткод: " : "Суперкоманды:    ")
+                  << dispatches / rounds << " команд за прогон, " << rounds * loops / t / 1e6 << " млн циклов/с, "
+                  << dispatches / t / 1e6 << " млн команд/с\n";
+    }
+    std::cout << "\n";
+}
+
+/// Задержка JIT-компиляции против выигрыша во времени выполнения.
+void benchJit()
+{
+    std::cout << "=== JIT ===\n";
+    for (size_t loops : {100, 10000, 100000})
+    {
+        auto ast = LRParser(tokenize(generateTerminatingProgram(loops))).parse();
+
+        Stopwatch compileJit;
+        JitProgram jit = JitProgram::compile(ast);
+        double jitCompile = compileJit.seconds();
+        Stopwatch compileVm;
+        Bytecode bytecode = Compiler::compile(ast, CompileMode::Super);
+        double vmCompile = compileVm.seconds();
+
+        const int rounds = 20;
+        double jitRun = 0, vmRun = 0;
+        std::mt19937 rng(1);
+        for (int r = 0; r < rounds; ++r)
+        {
+            std::vector<std::int64_t> env(bytecode.vars.size());
+            for (auto &v : env)
+                v = rng() % 30;
+            std::vector<std::int64_t> copy = env;
+            Stopwatch a;
+            jit.run(env);
+            jitRun += a.seconds();
+            Stopwatch b;
+            execute(bytecode, copy);
+            vmRun += b.seconds();
+        }
+        jitRun /= rounds;
+        vmRun /= rounds;
+
+        std::cout << loops << " циклов (" << (jit.native() ? "x86-64" : "интерпретатор") << "): компиляция JIT "
+                  << jitCompile * 1e6 << " мкс, байткода " << vmCompile * 1e6 << " мкс; прогон JIT "
+                  << jitRun * 1e6 << " мкс, ВМ " << vmRun * 1e6 << " мкс";
+        if (vmRun > jitRun)
+            std::cout << "; окупается после " << (jitCompile - vmCompile) / (vmRun - jitRun) << " прогонов";
+        std::cout << "\n";
+    }
+    std::cout << "\n";
+}
+
+/// Параллельное выполнение независимых циклов против последовательного.
+void benchParallel()
+{
+    std::cout << "=== Параллельное выполнение ===\n";
+    const size_t loops = 1000000;
+    auto ast = LRParser(tokenize(generateTerminatingProgram(loops, 100000))).parse();
+    ParallelProgram program = ParallelProgram::compile(ast);
+    Bytecode closed = Compiler::compile(ast, CompileMode::Closed);
+
+    Stopwatch sequential;
+    std::vector<std::int64_t> env;
+    execute(closed, env);
+    double base = sequential.seconds();
+    std::cout << loops << " циклов, " << program.depth() << " уровней; последовательно " << base * 1e3 << " мс\n";
+
+    for (size_t threads : {1u, 2u, 4u, 8u})
+    {
+        ThreadPool pool(threads);
+        std::vector<std::int64_t> parallelEnv;
+        Stopwatch timer;
+        program.run(parallelEnv, pool);
+        double t = timer.seconds();
+        std::cout << threads << " потоков: " << t * 1e3 << " мс, результат "
+                  << (parallelEnv == env ? "совпадает" : "НЕ совпадает") << "\n";
+    }
+    std::cout << "\n";
+}
+
+/// Пакетное выполнение: окружений в секунду для AVX2 и скалярного пути.
+void benchBatch()
+{
+    std::cout << "=== Пакетное выполнение ===\n";
+    auto ast = LRParser(tokenize(generateTerminatingProgram(200, 16))).parse();
+    BatchProgram batch = BatchProgram::compile(ast);
+
+    const size_t lanes = 1 << 18;
+    BatchEnv env(lanes, batch.vars().size());
+    std::mt19937 rng(5);
+    for (size_t lane = 0; lane < lanes; ++lane)
+        for (size_t v = 0; v < env.vars(); ++v)
+            env.at(lane, v) = static_cast<std::int32_t>(rng() % 30);
+
+    for (bool vector : {false, true})
+    {
+        if (vector && !BatchProgram::vectorized())
+            break;
+        BatchEnv work = env;
+        Stopwatch timer;
+        batch.run(work, vector);
+        double t = timer.seconds();
+        std::cout << (vector ? "AVX2:     " : "Скалярно: ") << lanes / t / 1e6 << " млн окружений/с (программа из 200 циклов)\n";
+    }
+    std::cout << "\n";
+}
+
+int main()
+{
+    benchLexer();
+    benchLineIndex();
+    benchTokenStream();
+    benchArena();
+    benchDiff();
+    benchVM();
+    benchJit();
+    benchParallel();
+    benchBatch();
+    return 0;
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "main.hpp"
+
+#include <array>
+
+/// Лексический и синтаксический анализ программ, записанных литералом в исходном
+/// коде C++, во время компиляции (C++20). Пример:
+///
+///     constexpr auto program = ct::compile<"while (x < V) y := I done">();
+///
+/// Синтаксическая ошибка в литерале становится ошибкой сборки: сообщение
+/// выбрасывается исключением внутри consteval-функции и выводится компилятором.
+/// Все буферы имеют размер, вычисленный по самому литералу, поэтому разбор
+/// не использует динамическую память и при запуске ничего не стоит.
+namespace ct {
+
+/// Строковый литерал как параметр шаблона.
+template <size_t N>
+struct FixedString {
+    char data[N] = {};
+    constexpr FixedString(const char (&s)[N]) {
+        for (size_t i = 0; i < N; ++i) data[i] = s[i];
+    }
+    constexpr std::string_view view() const { return {data, N - 1}; }
+};
+
+/// Токен времени компиляции: тип и положение в исходной строке.
+struct StaticToken {
+    TokenType type = TokenType::END;
+    size_t begin = 0;
+    size_t length = 0;
+};
+
+/// Операнд условия или правой части присваивания.
+struct StaticOperand {
+    bool variable = false;  ///< Переменная (иначе римское число).
+    std::uint16_t slot = 0; ///< Номер переменной в StaticProgram::variables.
+    int value = 0;          ///< Значение числа.
+    std::string_view text;  ///< Запись в исходном тексте.
+};
+
+/// Один цикл while (lhs op rhs) target := value done.
+struct StaticLoop {
+    StaticOperand lhs;
+    TokenType op = TokenType::LESS; ///< LESS, GREATER или EQUAL.
+    StaticOperand rhs;
+    std::uint16_t target = 0;       ///< Номер присваиваемой переменной.
+    StaticOperand value;
+};
+
+/// Разобранная программа: плоский список циклов с разрешёнными номерами переменных.
+template <size_t Loops, size_t Vars>
+struct StaticProgram {
+    std::array<StaticLoop, Loops> loops{};
+    std::array<std::string_view, Vars> variables{};
+
+    constexpr size_t size() const { return Loops; }
+
+    /// Строит обычный AST (для печати и остальных инструментов).
+    std::shared_ptr<ASTNode> toAST(ASTFactory& factory) const {
+        auto operand = [&](const StaticOperand& op) {
+            return factory.make(op.variable ? "Identifier" : "RomanNumeral", std::string(op.text));
+        };
+        std::vector<std::shared_ptr<ASTNode>> statements;
+        for (const auto& loop : loops) {
+            const char* op = loop.op == TokenType::LESS ? "<" : loop.op == TokenType::GREATER ? ">" : "=";
+            auto cond = factory.make("Condition", "", {operand(loop.lhs), factory.make("RelOp", op), operand(loop.rhs)});
+            auto body = factory.make("Assignment", "", {factory.make("LValue", std::string(variables[loop.target])),
+                                                         operand(loop.value)});
+            statements.push_back(factory.make("WhileLoop", "", {cond, body}));
+        }
+        return factory.make("Program", "", {factory.make("StatementList", "", std::move(statements))});
+    }
+};
+
+/// Ошибка в лексеме, начинающейся в позиции i, или nullptr. Проверки те же,
+/// что в tokenizeInto(): лексема найдена, а байты вне ASCII в идентификаторе —
+/// верный UTF-8 и буквы европейских алфавитов (isEuropeanLetter).
+constexpr const char* lexemeError(std::string_view input, size_t i, Lexeme lexeme) {
+    if (lexeme.length == 0) return "Ошибка лексики: недопустимый символ";
+    if (lexeme.type != TokenType::IDENTIFIER) return nullptr;
+    for (size_t k = i, end = i + lexeme.length; k < end;) {
+        if (static_cast<unsigned char>(input[k]) < 0x80) { k++; continue; }
+        size_t length = utf8Length(input, k);
+        if (length == 0 || k + length > end) return "Ошибка лексики: неверная последовательность UTF-8";
+        if (!isEuropeanLetter(decodeUtf8(input, k))) return "Ошибка лексики: недопустимый символ";
+    }
+    return nullptr;
+}
+
+/// Первая лексическая ошибка во входе или nullptr, если tokenize() его примет.
+constexpr const char* lexicalError(std::string_view input) {
+    for (size_t i = 0; i < input.size();) {
+        if (isSpaceChar(input[i])) { i++; continue; }
+        Lexeme lexeme = scanToken(input, i);
+        if (const char* error = lexemeError(input, i, lexeme)) return error;
+        i += lexeme.length;
+    }
+    return nullptr;
+}
+
+/// Считает токены (без END); лексическая ошибка — ошибка сборки.
+constexpr size_t countTokens(std::string_view input) {
+    size_t count = 0;
+    for (size_t i = 0; i < input.size();) {
+        if (isSpaceChar(input[i])) { i++; continue; }
+        Lexeme lexeme = scanToken(input, i);
+        if (const char* error = lexemeError(input, i, lexeme)) throw error;
+        i += lexeme.length;
+        count++;
+    }
+    return count;
+}
+
+/// Разбивает строку на токены в буфер фиксированного размера N + 1 (с END).
+template <size_t N>
+constexpr std::array<StaticToken, N + 1> tokenize(std::string_view input) {
+    std::array<StaticToken, N + 1> tokens{};
+    size_t count = 0;
+    for (size_t i = 0; i < input.size();) {
+        if (isSpaceChar(input[i])) { i++; continue; }
+        Lexeme lexeme = scanToken(input, i);
+        if (const char* error = lexemeError(input, i, lexeme)) throw error;
+        tokens[count++] = {lexeme.type, i, lexeme.length};
+        i += lexeme.length;
+    }
+    tokens[count] = {TokenType::END, input.size(), 0};
+    return tokens;
+}
+
+/// Рекурсивный спуск по той же грамматике, что и LRParser, над массивом токенов.
+/// Если buffers пусты (Loops = Vars = 0), только считает циклы и переменные.
+template <size_t N, size_t Loops, size_t Vars>
+struct Parser {
+    std::string_view input;
+    std::array<StaticToken, N + 1> tokens;
+    size_t pos = 0;
+    size_t loopCount = 0;
+    size_t varCount = 0;
+    StaticProgram<Loops, Vars> program{};
+    std::array<std::string_view, N> names{}; ///< Имена переменных по порядку появления.
+
+    constexpr const StaticToken& current() const { return tokens[pos]; }
+    constexpr std::string_view text() const { return input.substr(current().begin, current().length); }
+
+    constexpr void consume(TokenType expected) {
+        if (current().type != expected) throw "Синтаксическая ошибка";
+        pos++;
+    }
+
+    constexpr std::uint16_t slot(std::string_view name) {
+        for (size_t i = 0; i < varCount; ++i)
+            if (names[i] == name) return static_cast<std::uint16_t>(i);
+        names[varCount] = name;
+        if constexpr (Vars > 0) program.variables[varCount] = name;
+        return static_cast<std::uint16_t>(varCount++);
+    }
+
+    constexpr StaticOperand parseExpression() {
+        StaticOperand op;
+        op.text = text();
+        if (current().type == TokenType::IDENTIFIER) {
+            op.variable = true;
+            op.slot = slot(op.text);
+        } else if (current().type == TokenType::ROMAN_NUMERAL) {
+            op.value = romanToInt(op.text);
+        } else {
+            throw "Ожидалось выражение";
+        }
+        pos++;
+        return op;
+    }
+
+    constexpr void parseStatement() {
+        StaticLoop loop;
+        consume(TokenType::WHILE);
+        consume(TokenType::LPAREN);
+        loop.lhs = parseExpression();
+        loop.op = current().type;
+        if (loop.op != TokenType::LESS && loop.op != TokenType::GREATER && loop.op != TokenType::EQUAL)
+            throw "Ожидался оператор сравнения";
+        pos++;
+        loop.rhs = parseExpression();
+        consume(TokenType::RPAREN);
+        loop.target = slot(text());
+        consume(TokenType::IDENTIFIER);
+        consume(TokenType::ASSIGN);
+        loop.value = parseExpression();
+        consume(TokenType::DONE);
+        if constexpr (Loops > 0) program.loops[loopCount] = loop;
+        loopCount++;
+    }
+
+    constexpr void parse() {
+        parseStatement();
+        while (current().type == TokenType::SEMICOLON) {
+            consume(TokenType::SEMICOLON);
+            parseStatement();
+        }
+        consume(TokenType::END);
+    }
+};
+
+/// Разбирает литерал программы во время компиляции.
+template <FixedString Src>
+consteval auto compile() {
+    constexpr std::string_view input = Src.view();
+    constexpr size_t n = countTokens(input);
+    constexpr auto sizes = [&] {
+        Parser<n, 0, 0> counter{input, tokenize<n>(input)};
+        counter.parse();
+        return std::array<size_t, 2>{counter.loopCount, counter.varCount};
+    }();
+
+    Parser<n, sizes[0], sizes[1]> parser{input, tokenize<n>(input)};
+    parser.parse();
+    return parser.program;
+}
+
+} // namespace ct
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "main.hpp"
+
+#include <cstdlib>
+
+/// Вид различия между двумя версиями программы.
+enum class DiffKind { Added, Removed, Modified };
+
+/// Одно найденное различие.
+struct DiffEntry {
+    DiffKind kind;                   ///< Добавлен, удалён или изменён узел.
+    std::size_t statement;           ///< Индекс цикла в новой версии (для Removed — в старой).
+    std::string path;                ///< Путь к узлу, например "WhileLoop[3]/Condition/RelOp".
+    std::shared_ptr<ASTNode> before; ///< Узел старой версии (nullptr для Added).
+    std::shared_ptr<ASTNode> after;  ///< Узел новой версии (nullptr для Removed).
+};
+
+/// Сравнивает два AST сверху вниз по структурным (меркловым) хешам, которые
+/// ASTFactory вычисляет снизу вверх во время разбора. Спуск выполняется
+/// только в поддеревья с несовпадающими хешами. В списке операторов общие
+/// префикс и суффикс находятся двоичным поиском по накопленным хешам
+/// (ListNode::prefixHash), а середина выравнивается алгоритмом Майерса по
+/// хешам циклов за O((m + k) · D), где D — число вставок и удалений: сдвиг
+/// циклов после вставки не считается их изменением.
+class ASTDiff {
+    /// Больше правок выравнивание не ищет: середина сопоставляется попарно.
+    static constexpr size_t MaxEdits = 1024;
+
+    std::vector<DiffEntry> entries;
+
+    void report(DiffKind kind, std::size_t stmt, const std::string& path,
+                std::shared_ptr<ASTNode> before, std::shared_ptr<ASTNode> after) {
+        entries.push_back({kind, stmt, path, std::move(before), std::move(after)});
+    }
+
+    /// Сравнивает узлы одной позиции.
+    void compare(const std::shared_ptr<ASTNode>& a, const std::shared_ptr<ASTNode>& b,
+                 std::size_t stmt, const std::string& path) {
+        if (a->hash == b->hash) return;
+        if (a->type == "StatementList" && b->type == "StatementList") {
+            compareList(*a, *b, path);
+            return;
+        }
+        if (a->type != b->type || a->value != b->value || a->children.size() != b->children.size() ||
+            a->children.empty()) {
+            report(DiffKind::Modified, stmt, path, a, b);
+            return;
+        }
+        for (size_t i = 0; i < a->children.size(); ++i) {
+            compare(a->children[i], b->children[i], stmt, path + "/" + b->children[i]->type);
+        }
+    }
+
+    /// Длина общего начала (или конца) списков по накопленным хешам: равенство
+    /// хешей k первых элементов влечёт равенство и для меньших k.
+    static size_t commonRun(const std::vector<std::size_t>& a, const std::vector<std::size_t>& b, size_t limit) {
+        size_t lo = 0, hi = limit;
+        while (lo < hi) {
+            size_t mid = (lo + hi + 1) / 2;
+            if (a[mid] == b[mid]) lo = mid;
+            else hi = mid - 1;
+        }
+        return lo;
+    }
+
+    /// Кратчайший сценарий правок A → B (Майерс): '=' — совпадение, '-' — удаление
+    /// из A, '+' — вставка из B. Пустой результат — правок больше MaxEdits.
+    static std::string editScript(std::span<const std::shared_ptr<ASTNode>> a,
+                                  std::span<const std::shared_ptr<ASTNode>> b) {
+        long n = static_cast<long>(a.size()), m = static_cast<long>(b.size());
+        long limit = std::min<long>(n + m, MaxEdits);
+        if (std::abs(n - m) > limit) return ""; // Одних вставок или удалений больше MaxEdits
+        std::vector<long> v(2 * limit + 3, 0);
+        std::vector<std::vector<long>> trace; // trace[d][k + d] — x после d правок на диагонали k
+        auto at = [&](long k) -> long& { return v[k + limit + 1]; };
+        for (long d = 0; d <= limit; ++d) {
+            for (long k = -d; k <= d; k += 2) {
+                long x = (k == -d || (k != d && at(k - 1) < at(k + 1))) ? at(k + 1) : at(k - 1) + 1;
+                long y = x - k;
+                while (x < n && y < m && a[x]->hash == b[y]->hash) x++, y++;
+                at(k) = x;
+            }
+            trace.emplace_back(v.begin() + limit + 1 - d, v.begin() + limit + 2 + d);
+            if (std::abs(n - m) > d || at(n - m) < n) continue;
+
+            // Обратный проход от (n, m) к (0, 0)
+            std::string ops;
+            long x = n, y = m;
+            for (long e = d; e > 0; --e) {
+                const auto& prev = trace[e - 1];
+                long k = x - y;
+                auto old = [&](long kk) { return prev[kk + e - 1]; };
+                long prevK = (k == -e || (k != e && old(k - 1) < old(k + 1))) ? k + 1 : k - 1;
+                long prevX = old(prevK), prevY = prevX - prevK;
+                long startX = prevK == k + 1 ? prevX : prevX + 1;
+                for (; x > startX; --x, --y) ops += '=';
+                ops += prevK == k + 1 ? '+' : '-';
+                x = prevX, y = prevY;
+            }
+            for (; x > 0; --x) ops += '=';
+            return std::string(ops.rbegin(), ops.rend());
+        }
+        return "";
+    }
+
+    /// Сравнивает списки операторов: отсекает общие префикс и суффикс,
+    /// середину выравнивает по хешам. Между совпавшими циклами удалённые и
+    /// вставленные сопоставляются попарно (изменения внутри цикла), лишние
+    /// считаются удалёнными или добавленными.
+    void compareList(const ASTNode& before, const ASTNode& after, const std::string& path) {
+        std::span<const std::shared_ptr<ASTNode>> a = before.children, b = after.children;
+        size_t shorter = std::min(a.size(), b.size());
+        size_t prefix = 0, suffix = 0;
+        if (before.list && after.list) {
+            prefix = commonRun(before.list->prefixHash, after.list->prefixHash, shorter);
+            suffix = commonRun(before.list->suffixHash, after.list->suffixHash, shorter - prefix);
+        } else {
+            while (prefix < shorter && a[prefix]->hash == b[prefix]->hash) prefix++;
+            while (suffix < shorter - prefix && a[a.size() - 1 - suffix]->hash == b[b.size() - 1 - suffix]->hash)
+                suffix++;
+        }
+        auto middleA = a.subspan(prefix, a.size() - suffix - prefix);
+        auto middleB = b.subspan(prefix, b.size() - suffix - prefix);
+        std::string ops = editScript(middleA, middleB);
+        if (ops.empty()) {
+            // Правок слишком много или середина пуста: попарно по позиции
+            ops = std::string(std::min(middleA.size(), middleB.size()), '~');
+            ops += std::string(middleA.size() - std::min(middleA.size(), middleB.size()), '-');
+            ops += std::string(middleB.size() - std::min(middleA.size(), middleB.size()), '+');
+        }
+
+        auto name = [&](const std::shared_ptr<ASTNode>& node, size_t index) {
+            return path + "/" + node->type + "[" + std::to_string(index) + "]";
+        };
+        size_t i = prefix, j = prefix;
+        std::vector<size_t> removed, added;
+        auto flush = [&] {
+            size_t paired = std::min(removed.size(), added.size());
+            for (size_t k = 0; k < paired; ++k) compare(a[removed[k]], b[added[k]], added[k], name(b[added[k]], added[k]));
+            for (size_t k = paired; k < removed.size(); ++k)
+                report(DiffKind::Removed, removed[k], name(a[removed[k]], removed[k]), a[removed[k]], nullptr);
+            for (size_t k = paired; k < added.size(); ++k)
+                report(DiffKind::Added, added[k], name(b[added[k]], added[k]), nullptr, b[added[k]]);
+            removed.clear();
+            added.clear();
+        };
+        for (char op : ops) {
+            if (op == '=') {
+                flush();
+                i++, j++;
+            } else if (op == '~') {
+                compare(a[i], b[j], j, name(b[j], j));
+                i++, j++;
+            } else if (op == '-') {
+                removed.push_back(i++);
+            } else {
+                added.push_back(j++);
+            }
+        }
+        flush();
+    }
+
+public:
+    /// Вычисляет различия между старой (before) и новой (after) версиями программы.
+    static std::vector<DiffEntry> run(const std::shared_ptr<ASTNode>& before, const std::shared_ptr<ASTNode>& after) {
+        ASTDiff diff;
+        diff.compare(before, after, 0, before->type);
+        return std::move(diff.entries);
+    }
+};
+
+/// Выводит список различий в читаемом виде.
+void printDiff(const std::vector<DiffEntry>& diff) {
+    static const char* names[] = {"добавлено", "удалено", "изменено"};
+    for (const auto& entry : diff) {
+        std::cout << names[static_cast<int>(entry.kind)] << ": " << entry.path;
+        if (entry.before && entry.after && !entry.before->value.empty()) {
+            std::cout << " (" << entry.before->value << " -> " << entry.after->value << ")";
+        }
+        std::cout << "\n";
+    }
+}
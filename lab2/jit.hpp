@@ -0,0 +1,169 @@
+#pragma once
+
+#include "vm.hpp"
+
+#include <cstring>
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define WHILE_JIT_X86_64 1
+#endif
+
+/// JIT-компилятор программ в машинный код x86-64.
+///
+/// Каждый цикл while (a op b) t := e done превращается в
+///     head: mov rax, a; cmp rax, b; j!op exit
+///           test rsi, rsi; jz out_of_fuel; dec rsi
+///           mov rax, e; mov [rdi + 8*t], rax
+///           jmp head
+///     exit: ...
+/// Переменные лежат в массиве int64 (регистровом файле), адрес которого
+/// передаётся в rdi; rsi — лимит итераций. Лимит проверяется перед телом
+/// цикла: при fuel = N выполняется не больше N итераций, и цикл ровно из N
+/// итераций завершается, а при fuel = 0 первая же итерация исчерпывает лимит. Код пишется в буфер mmap и перед
+/// запуском переключается с записи на исполнение (W^X). На других платформах,
+/// при ошибке mmap или слишком больших константах программа выполняется
+/// интерпретатором байткода.
+class JitProgram {
+    using Entry = int (*)(std::int64_t* vars, std::uint64_t fuel);
+
+    VarTable table;
+    Bytecode fallback;
+    void* memory = nullptr;
+    std::size_t capacity = 0;
+    Entry entry = nullptr;
+
+#ifdef WHILE_JIT_X86_64
+    std::vector<unsigned char> code;
+
+    void bytes(std::initializer_list<unsigned char> b) { code.insert(code.end(), b); }
+    void imm32(std::int64_t v) {
+        auto u = static_cast<std::uint32_t>(v);
+        for (int i = 0; i < 4; ++i) code.push_back(static_cast<unsigned char>(u >> (8 * i)));
+    }
+    void disp(std::uint32_t var) { imm32(static_cast<std::int64_t>(var) * 8); }
+    /// Дописывает rel32 перехода на target позже (позиция поля возвращается).
+    std::size_t jumpField() {
+        std::size_t at = code.size();
+        imm32(0);
+        return at;
+    }
+    void patch(std::size_t field, std::size_t target) {
+        auto rel = static_cast<std::int64_t>(target) - static_cast<std::int64_t>(field + 4);
+        auto u = static_cast<std::uint32_t>(rel);
+        std::memcpy(&code[field], &u, 4);
+    }
+
+    /// Операнд: номер переменной или константа; false, если константа не влезает в imm32.
+    bool operand(const std::shared_ptr<ASTNode>& node, bool& variable, std::int64_t& value) {
+        variable = node->type != "RomanNumeral";
+        value = variable ? table.intern(node->value) : romanToInt(node->value);
+        return variable || (value >= INT32_MIN && value <= INT32_MAX);
+    }
+
+    bool emitProgram(const std::shared_ptr<ASTNode>& program) {
+        std::vector<std::size_t> fuelExits;
+        for (const auto& loop : program->children[0]->children) {
+            const auto& cond = loop->children[0];
+            const auto& body = loop->children[1];
+            bool lv, rv, ev;
+            std::int64_t l, r, e;
+            if (!operand(cond->children[0], lv, l) || !operand(cond->children[2], rv, r)) return false;
+            auto target = table.intern(body->children[0]->value);
+            if (!operand(body->children[1], ev, e)) return false;
+            char rel = cond->children[1]->value[0];
+
+            std::size_t head = code.size();
+            if (lv) { bytes({0x48, 0x8B, 0x87}); disp(static_cast<std::uint32_t>(l)); } // mov rax, [rdi+8*l]
+            else { bytes({0x48, 0xC7, 0xC0}); imm32(l); }                              // mov rax, imm32
+            if (rv) { bytes({0x48, 0x3B, 0x87}); disp(static_cast<std::uint32_t>(r)); } // cmp rax, [rdi+8*r]
+            else { bytes({0x48, 0x3D}); imm32(r); }                                     // cmp rax, imm32
+            bytes({0x0F, static_cast<unsigned char>(rel == '<' ? 0x8D : rel == '>' ? 0x8E : 0x85)}); // jge/jle/jne exit
+            std::size_t exitField = jumpField();
+            bytes({0x48, 0x85, 0xF6});                                                  // test rsi, rsi
+            bytes({0x0F, 0x84});                                                        // jz out_of_fuel
+            fuelExits.push_back(jumpField());
+            bytes({0x48, 0xFF, 0xCE});                                                  // dec rsi
+
+            if (ev) { bytes({0x48, 0x8B, 0x87}); disp(static_cast<std::uint32_t>(e)); }
+            else { bytes({0x48, 0xC7, 0xC0}); imm32(e); }
+            bytes({0x48, 0x89, 0x87}); disp(target);                                    // mov [rdi+8*t], rax
+            bytes({0xE9});                                                              // jmp head
+            patch(jumpField(), head);
+            patch(exitField, code.size());
+        }
+        bytes({0x31, 0xC0, 0xC3});                                                      // xor eax, eax; ret
+        for (std::size_t field : fuelExits) patch(field, code.size());
+        bytes({0xB8, 0x01, 0x00, 0x00, 0x00, 0xC3});                                    // mov eax, 1; ret
+        return true;
+    }
+
+    /// Копирует код в исполняемую память; при ошибке ничего не остаётся отображённым.
+    bool install() {
+        capacity = code.size();
+        memory = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            memory = nullptr;
+            capacity = 0;
+            return false;
+        }
+        std::memcpy(memory, code.data(), code.size());
+        if (mprotect(memory, capacity, PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, capacity);
+            memory = nullptr;
+            capacity = 0;
+            return false;
+        }
+        entry = reinterpret_cast<Entry>(memory);
+        return true;
+    }
+#endif
+
+public:
+    JitProgram() = default;
+    JitProgram(const JitProgram&) = delete;
+    JitProgram& operator=(const JitProgram&) = delete;
+    JitProgram(JitProgram&& other) noexcept { *this = std::move(other); }
+    JitProgram& operator=(JitProgram&& other) noexcept {
+        std::swap(table, other.table);
+        std::swap(fallback, other.fallback);
+        std::swap(memory, other.memory);
+        std::swap(capacity, other.capacity);
+        std::swap(entry, other.entry);
+        return *this;
+    }
+    ~JitProgram() {
+#ifdef WHILE_JIT_X86_64
+        if (memory) munmap(memory, capacity);
+#endif
+    }
+
+    /// Компилирует AST программы; при невозможности JIT готовит байткод.
+    static JitProgram compile(const std::shared_ptr<ASTNode>& program) {
+        JitProgram jit;
+#ifdef WHILE_JIT_X86_64
+        if (jit.emitProgram(program) && jit.install()) {
+            jit.code = {};
+            return jit;
+        }
+        jit.table = VarTable();
+#endif
+        jit.fallback = Compiler::compile(program, CompileMode::Super);
+        jit.table = jit.fallback.vars;
+        return jit;
+    }
+
+    /// true, если программа выполняется машинным кодом.
+    bool native() const { return entry != nullptr; }
+
+    /// Переменные программы (номера совпадают с номерами ячеек env).
+    const VarTable& vars() const { return table; }
+
+    /// Выполняет программу над env; fuel — лимит итераций циклов (для JIT,
+    /// проверяется перед телом цикла) или команд (для интерпретатора).
+    /// Возвращает false, если лимит исчерпан.
+    bool run(std::vector<std::int64_t>& env, std::uint64_t fuel = UINT64_MAX) const {
+        if (env.size() < table.size()) env.resize(table.size(), 0);
+        if (entry) return entry(env.data(), fuel) == 0;
+        return execute(fallback, env, fuel).finished;
+    }
+};
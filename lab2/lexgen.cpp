@@ -0,0 +1,34 @@
+#include "lexgen.hpp"
+
+#include <fstream>
+#include <iostream>
+
+/// Генератор таблиц лексера:
+///   lexgen.exe <описание лексем> > <заголовок>
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Использование: " << argv[0] << " <описание лексем>\n";
+        return 1;
+    }
+    std::ifstream in(argv[1]);
+    if (!in)
+    {
+        std::cerr << "Не удалось открыть " << argv[1] << "\n";
+        return 1;
+    }
+    std::stringstream spec;
+    spec << in.rdbuf();
+
+    try
+    {
+        LexerGenerator::writeHeader(LexerGenerator::build(parseTokenRules(spec.str())), argv[1], std::cout);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << argv[1] << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Определение лексемы для генератора лексера.
+struct TokenRule {
+    std::string name;    ///< Имя элемента TokenType.
+    std::string pattern; ///< Регулярное выражение.
+    int priority = 0;    ///< При равной длине совпадения побеждает меньший приоритет.
+};
+
+/// Разбирает описание лексем: строки «ИМЯ образец приоритет», '#' — комментарий.
+/// @throws std::runtime_error с номером строки при ошибке.
+std::vector<TokenRule> parseTokenRules(std::string_view text) {
+    std::vector<TokenRule> rules;
+    std::istringstream in{std::string(text)};
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        if (line.find_first_not_of(" \t") == std::string::npos || line[line.find_first_not_of(" \t")] == '#') continue;
+        std::istringstream words(line);
+        TokenRule rule;
+        if (!(words >> rule.name >> rule.pattern >> rule.priority))
+            throw std::runtime_error("строка " + std::to_string(number) + ": ожидалось «ИМЯ образец приоритет»");
+        rules.push_back(rule);
+    }
+    return rules;
+}
+
+/// Таблицы лексера: минимальный ДКА по всем лексемам сразу.
+/// Состояние 0 — тупиковое, алфавит сжат до классов байтов.
+struct LexerTables {
+    std::vector<std::string> names;          ///< Имена лексем (индексы в accept).
+    std::array<std::uint8_t, 256> classOf{}; ///< Класс каждого байта.
+    int classes = 0;
+    int start = 1;
+    std::vector<int> next;                   ///< next[state * classes + class]
+    std::vector<int> accept;                 ///< Номер лексемы или -1.
+
+    size_t states() const { return accept.size(); }
+
+    /// Самое длинное совпадение с начала input: (номер лексемы, длина) или (-1, 0).
+    std::pair<int, size_t> match(std::string_view input) const {
+        std::pair<int, size_t> best{-1, 0};
+        int state = start;
+        for (size_t j = 0; j < input.size(); ++j) {
+            state = next[state * classes + classOf[static_cast<unsigned char>(input[j])]];
+            if (state == 0) break;
+            if (accept[state] != -1) best = {accept[state], j + 1};
+        }
+        return best;
+    }
+};
+
+/// Генератор лексера с выбором самого длинного совпадения (maximal munch):
+/// образцы → НКА Томпсона → ДКА подмножеств → минимизация разбиением Мура.
+/// Образцы поддерживают литералы, \c (экранирование), \xHH (байт), классы [a-z...],
+/// скобки, | и постфиксные *, +, ?.
+class LexerGenerator {
+    using CharSet = std::bitset<256>;
+    struct NfaState {
+        std::vector<int> epsilon;
+        CharSet set;     ///< Переход по символам из set ...
+        int target = -1; ///< ... в состояние target.
+        int rule = -1;   ///< Принимающее для лексемы rule.
+    };
+    std::vector<NfaState> nfa;
+
+    int add() {
+        nfa.emplace_back();
+        return static_cast<int>(nfa.size() - 1);
+    }
+
+    /// Фрагмент НКА с одним входом и одним выходом.
+    struct Fragment {
+        int in, out;
+    };
+
+    /// Рекурсивный спуск по образцу.
+    class PatternParser {
+        LexerGenerator& g;
+        std::string_view p;
+        size_t i = 0;
+
+        [[noreturn]] void fail(const std::string& message) {
+            throw std::runtime_error("образец " + std::string(p) + ", позиция " + std::to_string(i) + ": " + message);
+        }
+
+        unsigned char literal() {
+            if (i >= p.size()) fail("неожиданный конец");
+            if (p[i] == '\\') {
+                if (++i >= p.size()) fail("\\ в конце образца");
+                if (p[i] == 'x' && i + 2 < p.size() && isxdigit(static_cast<unsigned char>(p[i + 1])) &&
+                    isxdigit(static_cast<unsigned char>(p[i + 2]))) {
+                    i += 3;
+                    return static_cast<unsigned char>(std::stoi(std::string(p.substr(i - 2, 2)), nullptr, 16));
+                }
+            }
+            return static_cast<unsigned char>(p[i++]);
+        }
+
+        Fragment symbols(const CharSet& set) {
+            Fragment f{g.add(), g.add()};
+            g.nfa[f.in].set = set;
+            g.nfa[f.in].target = f.out;
+            return f;
+        }
+
+        Fragment atom() {
+            if (p[i] == '(') {
+                ++i;
+                Fragment f = alternation();
+                if (i >= p.size() || p[i] != ')') fail("ожидалась )");
+                ++i;
+                return f;
+            }
+            CharSet set;
+            if (p[i] == '[') {
+                ++i;
+                while (i < p.size() && p[i] != ']') {
+                    unsigned char from = literal(), to = from;
+                    if (i + 1 < p.size() && p[i] == '-' && p[i + 1] != ']') {
+                        ++i;
+                        to = literal();
+                    }
+                    for (int c = from; c <= to; ++c) set.set(c);
+                }
+                if (i >= p.size()) fail("ожидалась ]");
+                ++i;
+                return symbols(set);
+            }
+            set.set(literal());
+            return symbols(set);
+        }
+
+        Fragment repetition() {
+            Fragment f = atom();
+            while (i < p.size() && (p[i] == '*' || p[i] == '+' || p[i] == '?')) {
+                char op = p[i++];
+                Fragment r{g.add(), g.add()};
+                g.nfa[r.in].epsilon.push_back(f.in);
+                g.nfa[f.out].epsilon.push_back(r.out);
+                if (op != '+') g.nfa[r.in].epsilon.push_back(r.out);
+                if (op != '?') g.nfa[f.out].epsilon.push_back(f.in);
+                f = r;
+            }
+            return f;
+        }
+
+        Fragment concatenation() {
+            Fragment f{g.add(), -1};
+            f.out = f.in;
+            while (i < p.size() && p[i] != '|' && p[i] != ')') {
+                Fragment next = repetition();
+                g.nfa[f.out].epsilon.push_back(next.in);
+                f.out = next.out;
+            }
+            return f;
+        }
+
+    public:
+        PatternParser(LexerGenerator& generator, std::string_view pattern) : g(generator), p(pattern) {}
+
+        Fragment alternation() {
+            Fragment f = concatenation();
+            if (i >= p.size() || p[i] != '|') return f;
+            Fragment r{g.add(), g.add()};
+            g.nfa[r.in].epsilon.push_back(f.in);
+            g.nfa[f.out].epsilon.push_back(r.out);
+            while (i < p.size() && p[i] == '|') {
+                ++i;
+                Fragment next = concatenation();
+                g.nfa[r.in].epsilon.push_back(next.in);
+                g.nfa[next.out].epsilon.push_back(r.out);
+            }
+            return r;
+        }
+
+        Fragment parse() {
+            if (p.empty()) fail("пустой образец");
+            Fragment f = alternation();
+            if (i != p.size()) fail("лишняя )");
+            return f;
+        }
+    };
+
+    /// Замыкание по ε-переходам (множество — отсортированный вектор).
+    std::vector<int> closure(std::vector<int> states) const {
+        std::vector<bool> seen(nfa.size());
+        for (int s : states) seen[s] = true;
+        for (size_t k = 0; k < states.size(); ++k)
+            for (int t : nfa[states[k]].epsilon)
+                if (!seen[t]) {
+                    seen[t] = true;
+                    states.push_back(t);
+                }
+        std::sort(states.begin(), states.end());
+        return states;
+    }
+
+public:
+    /// Строит таблицы лексера.
+    /// @throws std::runtime_error при ошибке в образце или образце, допускающем пустую строку.
+    static LexerTables build(const std::vector<TokenRule>& rules) {
+        LexerGenerator g;
+        int root = g.add();
+        for (size_t r = 0; r < rules.size(); ++r) {
+            Fragment f = PatternParser(g, rules[r].pattern).parse();
+            g.nfa[root].epsilon.push_back(f.in);
+            g.nfa[f.out].rule = static_cast<int>(r);
+        }
+
+        // Лучшая лексема множества состояний: меньший приоритет, затем более раннее определение
+        auto bestRule = [&](const std::vector<int>& set) {
+            int best = -1;
+            for (int s : set) {
+                int r = g.nfa[s].rule;
+                if (r != -1 && (best == -1 || rules[r].priority < rules[best].priority ||
+                                (rules[r].priority == rules[best].priority && r < best)))
+                    best = r;
+            }
+            return best;
+        };
+
+        // Построение подмножеств; множество {} — тупиковое состояние 0
+        std::map<std::vector<int>, int> number{{{}, 0}};
+        std::vector<std::vector<int>> sets{{}};
+        std::vector<std::array<int, 256>> dfa(1);
+        dfa[0].fill(0);
+        std::vector<int> start = g.closure({root});
+        if (int rule = bestRule(start); rule != -1)
+            throw std::runtime_error("образец " + rules[rule].pattern + " допускает пустую строку");
+        number[start] = 1;
+        sets.push_back(start);
+        dfa.emplace_back();
+        for (size_t d = 1; d < sets.size(); ++d) {
+            for (int c = 0; c < 256; ++c) {
+                std::vector<int> moved;
+                for (int s : sets[d])
+                    if (g.nfa[s].target != -1 && g.nfa[s].set[c]) moved.push_back(g.nfa[s].target);
+                moved = g.closure(moved);
+                auto [it, added] = number.emplace(moved, static_cast<int>(sets.size()));
+                if (added) {
+                    sets.push_back(moved);
+                    dfa.emplace_back();
+                }
+                dfa[d][c] = it->second;
+            }
+        }
+
+        // Минимизация: разбиение по лексеме, затем уточнение по блокам целей;
+        // состояния, эквивалентные тупиковому, сливаются с ним
+        size_t n = sets.size();
+        std::vector<int> block(n);
+        for (size_t d = 0; d < n; ++d) block[d] = bestRule(sets[d]) + 1;
+        for (size_t blocks = 0;;) {
+            std::map<std::vector<int>, int> signatures;
+            std::vector<int> refined(n);
+            for (size_t d = 0; d < n; ++d) {
+                std::vector<int> signature{block[d]};
+                for (int c = 0; c < 256; ++c) signature.push_back(block[dfa[d][c]]);
+                refined[d] = signatures.emplace(signature, static_cast<int>(signatures.size())).first->second;
+            }
+            block = refined;
+            if (signatures.size() == blocks) break;
+            blocks = signatures.size();
+        }
+
+        // Нумерация блоков: тупиковый — 0, начальный — 1, остальные по порядку
+        std::vector<int> renumber(n, -1);
+        int count = 0;
+        for (size_t d : {size_t(0), size_t(1)})
+            if (renumber[block[d]] == -1) renumber[block[d]] = count++;
+        for (size_t d = 0; d < n; ++d)
+            if (renumber[block[d]] == -1) renumber[block[d]] = count++;
+
+        LexerTables t;
+        for (const auto& rule : rules) t.names.push_back(rule.name);
+        t.start = renumber[block[1]];
+        std::vector<std::array<int, 256>> minimal(count);
+        t.accept.assign(count, -1);
+        for (size_t d = 0; d < n; ++d) {
+            int m = renumber[block[d]];
+            for (int c = 0; c < 256; ++c) minimal[m][c] = renumber[block[dfa[d][c]]];
+            t.accept[m] = d == 0 ? -1 : bestRule(sets[d]);
+        }
+
+        // Сжатие алфавита
+        std::map<std::vector<int>, int> columns;
+        for (int c = 0; c < 256; ++c) {
+            std::vector<int> column(count);
+            for (int s = 0; s < count; ++s) column[s] = minimal[s][c];
+            t.classOf[c] = static_cast<std::uint8_t>(columns.emplace(column, static_cast<int>(columns.size())).first->second);
+        }
+        t.classes = static_cast<int>(columns.size());
+        t.next.resize(count * t.classes);
+        for (int s = 0; s < count; ++s)
+            for (int c = 0; c < 256; ++c) t.next[s * t.classes + t.classOf[c]] = minimal[s][c];
+        return t;
+    }
+
+    /// Записывает таблицы как заголовок C++ с constexpr-массивами (для scanToken).
+    /// Строки таблицы переходов выровнены до степени двойки lexStride, а переходы
+    /// хранят уже умноженное на неё смещение строки: на цепочке зависимостей
+    /// между символами остаётся одно чтение таблицы без умножения.
+    static void writeHeader(const LexerTables& t, const std::string& source, std::ostream& out) {
+        size_t stride = 1;
+        while (stride < static_cast<size_t>(t.classes)) stride *= 2;
+        const char* cell = t.states() * stride <= 256 ? "std::uint8_t" : t.states() * stride <= 65536 ? "std::uint16_t" : "std::uint32_t";
+        out << "// Сгенерировано lexgen.exe из " << source << ", не редактировать вручную.\n"
+            << "#pragma once\n\n#include <cstdint>\n\n"
+            << "/// Таблицы лексера: " << t.states() << " состояний, " << t.classes << " классов байтов.\n"
+            << "/// Состояние задаётся смещением строки (номер * lexStride); 0 — тупиковое.\n"
+            << "/// TokenType::END в lexAccept — непринимающее состояние, lexFinal — состояние без переходов.\n"
+            << "namespace lextab {\n\n"
+            << "inline constexpr unsigned lexStride = " << stride << ";\n"
+            << "inline constexpr unsigned lexStart = " << t.start * stride << ";\n\n"
+            << "inline constexpr std::uint8_t lexClass[256] = {";
+        for (int c = 0; c < 256; ++c) out << (c % 16 ? " " : "\n    ") << int(t.classOf[c]) << ",";
+        out << "\n};\n\ninline constexpr " << cell << " lexNext[" << t.states() * stride << "] = {";
+        for (size_t s = 0; s < t.states(); ++s) {
+            out << "\n   ";
+            for (size_t c = 0; c < stride; ++c)
+                out << " " << (c < static_cast<size_t>(t.classes) ? t.next[s * t.classes + c] * stride : 0) << ",";
+        }
+        out << "\n};\n\ninline constexpr TokenType lexAccept[" << t.states() << "] = {";
+        for (size_t s = 0; s < t.states(); ++s)
+            out << "\n    TokenType::" << (t.accept[s] == -1 ? "END" : t.names[t.accept[s]]) << ",";
+        // Состояния без переходов: совпадение нельзя продлить, следующий символ можно не читать
+        out << "\n};\n\ninline constexpr bool lexFinal[" << t.states() << "] = {";
+        for (size_t s = 0; s < t.states(); ++s) {
+            bool final = true;
+            for (int c = 0; c < t.classes; ++c) final = final && t.next[s * t.classes + c] == 0;
+            out << (s % 16 ? " " : "\n    ") << (final ? "true" : "false") << ",";
+        }
+        out << "\n};\n\n} // namespace lextab\n";
+    }
+};
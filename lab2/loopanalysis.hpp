@@ -0,0 +1,83 @@
+#pragma once
+
+#include "main.hpp"
+
+#include <optional>
+
+/// Сколько раз может выполниться тело цикла while (a op b) x := e done.
+///
+/// Тело — одно присваивание константы или переменной, поэтому после первой
+/// итерации состояние больше не меняется: второе выполнение x := e даёт то же
+/// самое. Значит, цикл выполняется 0 раз (условие ложно), 1 раз (присваивание
+/// делает условие ложным) или бесконечно (условие остаётся истинным).
+enum class TripCount {
+    Zero,              ///< Условие ложно при любых значениях переменных.
+    ZeroOrOne,         ///< После присваивания условие всегда ложно.
+    ZeroOrInfinite,    ///< Присваивание не может сделать условие ложным.
+    Infinite,          ///< Условие истинно при любых значениях переменных.
+    ZeroOneOrInfinite, ///< Зависит от значений переменных (проверяется при выполнении).
+};
+
+/// Операнд условия: переменная или римское число.
+struct LoopOperand {
+    bool variable;
+    std::string text; ///< Имя переменной или запись числа.
+
+    explicit LoopOperand(const std::shared_ptr<ASTNode>& node)
+        : variable(node->type != "RomanNumeral"), text(node->value) {}
+
+    bool operator==(const LoopOperand& other) const {
+        return variable == other.variable && text == other.text;
+    }
+};
+
+/// Значение условия, если оно не зависит от переменных: обе части — числа
+/// или одна и та же переменная.
+std::optional<bool> staticTruth(const LoopOperand& lhs, char rel, const LoopOperand& rhs) {
+    if (!lhs.variable && !rhs.variable) {
+        int l = romanToInt(lhs.text), r = romanToInt(rhs.text);
+        return rel == '<' ? l < r : rel == '>' ? l > r : l == r;
+    }
+    if (lhs == rhs) return rel == '=';
+    return std::nullopt;
+}
+
+/// Классифицирует цикл (узел WhileLoop) по числу итераций.
+TripCount classifyLoop(const std::shared_ptr<ASTNode>& loop) {
+    const auto& cond = loop->children[0];
+    const auto& body = loop->children[1];
+    LoopOperand lhs(cond->children[0]), rhs(cond->children[2]);
+    char rel = cond->children[1]->value[0];
+    const std::string& target = body->children[0]->value;
+    LoopOperand value(body->children[1]);
+
+    if (auto now = staticTruth(lhs, rel, rhs)) return *now ? TripCount::Infinite : TripCount::Zero;
+
+    // Условие после присваивания: x заменяется на e.
+    auto substitute = [&](const LoopOperand& op) { return op.variable && op.text == target ? value : op; };
+    LoopOperand lhsAfter = substitute(lhs), rhsAfter = substitute(rhs);
+    if (lhsAfter == lhs && rhsAfter == rhs) return TripCount::ZeroOrInfinite;
+
+    if (auto after = staticTruth(lhsAfter, rel, rhsAfter)) {
+        return *after ? TripCount::ZeroOrInfinite : TripCount::ZeroOrOne;
+    }
+    return TripCount::ZeroOneOrInfinite;
+}
+
+/// Классифицирует все циклы программы (корень Program).
+std::vector<TripCount> classifyLoops(const std::shared_ptr<ASTNode>& program) {
+    std::vector<TripCount> result;
+    for (const auto& loop : program->children[0]->children) result.push_back(classifyLoop(loop));
+    return result;
+}
+
+/// Номер первого цикла, который зацикливается при любых входных данных, или -1.
+/// Все циклы выполняются по порядку без ветвлений, поэтому такой цикл
+/// означает, что программа не завершается никогда, и её можно отвергнуть до запуска.
+long findCertainDivergence(const std::shared_ptr<ASTNode>& program) {
+    const auto& loops = program->children[0]->children;
+    for (size_t i = 0; i < loops.size(); ++i) {
+        if (classifyLoop(loops[i]) == TripCount::Infinite) return static_cast<long>(i);
+    }
+    return -1;
+}
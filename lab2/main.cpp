@@ -1,4 +1,15 @@
 #include "main.hpp"
+#include "diff.hpp"
+#include "symindex.hpp"
+#include "tokstream.hpp"
+#include "ctparse.hpp"
+#include "vm.hpp"
+#include "jit.hpp"
+#include "loopanalysis.hpp"
+#include "parallel.hpp"
+#include "batch.hpp"
+#include "lexgen.hpp"
+#include "arena.hpp"
 
 /// Главная функция: запускает тестовые примеры и выводит деревья разбора.
 int main()
@@ -39,5 +50,507 @@ int main()
 
     }
 
+    // Хеш-консинг: повторяющиеся условия и присваивания хранятся один раз
+    {
+        std::cout << "=== Хеш-консинг AST ===\n";
+        std::string program = "while (x < V) y := I done";
+        for (int i = 0; i < 999; ++i)
+        {
+            program += i % 2 ? "; while (x < V) y := I done" : "; while (y > X) x := y done";
+        }
+
+        LRParser parser(tokenize(program));
+        auto ast = parser.parse();
+        const auto &loops = ast->children[0]->children;
+
+        std::cout << "Узлов в дереве: " << parser.nodes().requested()
+                  << ", уникальных: " << parser.nodes().size() << "\n";
+        std::cout << "Циклы 1 и 3 разделены: " << (loops[0] == loops[2] ? "да" : "нет")
+                  << ", циклы 1 и 2 равны: " << (sameTree(loops[0], loops[1]) ? "да" : "нет") << "\n";
+
+        LRParser other(tokenize("while (x < V) y := I done"));
+        std::cout << "Равенство между фабриками: "
+                  << (sameTree(other.parse()->children[0]->children[0], loops[0]) ? "да" : "нет") << "\n\n";
+    }
+
+    // Структурный дифф двух версий программы по хешам поддеревьев
+    {
+        std::cout << "=== Сравнение версий программы ===\n";
+        std::string before, after;
+        for (int i = 0; i < 50; ++i)
+        {
+            std::string loop = "while (x" + std::to_string(i % 7) + " < V) y := I done";
+            before += (i ? "; " : "") + loop;
+            after += (i ? "; " : "") + (i == 20 ? std::string("while (x < X) y := I done") : loop);
+        }
+        after += "; while (z = I) z := II done";
+
+        auto oldAst = LRParser(tokenize(before)).parse();
+        auto newAst = LRParser(tokenize(after)).parse();
+        printDiff(ASTDiff::run(oldAst, newAst));
+
+        // Вставка у начала и удаление у конца: сдвинутые циклы не считаются изменёнными
+        for (int period : {1000, 7})
+        {
+            std::string first, second;
+            for (int i = 0; i < 40; ++i)
+            {
+                std::string loop = "while (x" + std::to_string(i % period) + " < V) y := I done";
+                first += (i ? "; " : "") + loop;
+                if (i == 2)
+                    second += "; while (n = I) n := X done";
+                if (i != 37)
+                    second += (i ? "; " : "") + loop;
+            }
+            auto diff = ASTDiff::run(LRParser(tokenize(first)).parse(), LRParser(tokenize(second)).parse());
+            size_t counts[3] = {0, 0, 0};
+            for (const auto& entry : diff)
+                counts[static_cast<int>(entry.kind)]++;
+            std::cout << (period == 7 ? "Повторяющиеся циклы" : "Разные циклы") << ": добавлено " << counts[0]
+                      << ", удалено " << counts[1] << ", изменено " << counts[2] << "\n";
+        }
+
+        // Списки очень разной длины: разница больше MaxEdits — сравнение по позиции
+        std::string many;
+        for (int i = 0; i < 3000; ++i)
+            many += (i ? "; " : "") + std::string("while (x") + std::to_string(i) + " < V) y := I done";
+        auto longAst = LRParser(tokenize(many)).parse();
+        auto shortAst = LRParser(tokenize("while (z = I) z := II done")).parse();
+        size_t removedAll = 0, addedAll = 0;
+        for (const auto& entry : ASTDiff::run(longAst, shortAst))
+            removedAll += entry.kind == DiffKind::Removed;
+        for (const auto& entry : ASTDiff::run(shortAst, longAst))
+            addedAll += entry.kind == DiffKind::Added;
+        std::cout << "3000 циклов против одного: удалено " << removedAll << ", обратно добавлено " << addedAll << "\n";
+        std::cout << "\n";
+    }
+
+    // Индекс переменных: запись на диск и поиск присваиваний через mmap
+    {
+        std::cout << "=== Индекс переменных ===\n";
+        SymbolIndexBuilder builder;
+        builder.addFile("a.wl", "while (x < V) y := I done; while (y > I) x := y done");
+        builder.addFile("b.wl", "while (z = I) x := X done");
+        builder.write("symindex.test.idx");
+
+        SymbolIndex index;
+        if (index.open("symindex.test.idx"))
+        {
+            index.find("x", SymbolRole::Assigned, [&](const Occurrence &occ)
+                       { std::cout << "x присваивается: " << index.fileName(occ.file) << ", цикл "
+                                   << occ.statement << ", токен " << occ.offset << "\n"; });
+            std::cout << "Чтений y: " << index.find("y", SymbolRole::Used, [](const Occurrence &) {}) << "\n";
+        }
+
+        // Усечённый и испорченный индексы отвергаются при открытии
+        std::ifstream in("symindex.test.idx", std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        auto openBytes = [&](const std::string &content)
+        {
+            std::ofstream("symindex.bad.idx", std::ios::binary) << content;
+            return index.open("symindex.bad.idx");
+        };
+        SymbolIndexHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        std::string badTerm = bytes;
+        badTerm[header.terms] = '\x7f'; // Имя первого терма далеко за пулом строк
+        std::string badList = bytes;
+        badList[header.terms + offsetof(IndexTermEntry, list) + 1] = '\x7f';
+        bool truncated = openBytes(bytes.substr(0, header.postings - 1));
+        bool term = openBytes(badTerm), list = openBytes(badList);
+        std::cout << "Открыт усечённый: " << (truncated ? "да" : "нет") << ", с неверным именем: " << (term ? "да" : "нет")
+                  << ", с неверным списком: " << (list ? "да" : "нет") << "\n";
+        bool reopened = openBytes(bytes) && index.open("symindex.test.idx");
+        std::cout << "Повторное открытие: " << (reopened ? "да" : "нет") << ", файлов " << index.files()
+                  << ", имя файла 5: '" << index.fileName(5) << "'\n\n";
+        std::remove("symindex.bad.idx");
+        std::remove("symindex.test.idx");
+    }
+
+    // Сжатый поток токенов разбирается без восстановления списка токенов
+    {
+        std::cout << "=== Сжатый поток токенов ===\n";
+        std::string program = tests[1] + "; while (IIII < XIV) x := IIII done";
+        auto tokens = tokenize(program);
+        std::string encoded = TokenStreamEncoder::encode(tokens);
+
+        TokenStreamDecoder decoder(encoded);
+        auto decoded = LRParser(decoder).parse();
+        std::cout << "Исходный текст: " << program.size() << " байт, поток: " << encoded.size() << " байт\n";
+        std::cout << "AST совпадает: " << (sameTree(decoded, LRParser(tokens).parse()) ? "да" : "нет") << "\n";
+
+        // Испорченные потоки: каждое чтение ограничено концом буфера
+        auto drain = [](const std::string &data)
+        {
+            TokenStreamDecoder broken(data);
+            size_t count = 0;
+            while (broken.next().type != TokenType::END)
+                count++;
+            return std::to_string(count) + " (" + (broken.error().empty() ? "без ошибки" : broken.error()) + ")";
+        };
+        std::string huge = "WLTS";
+        huge += '\xF6'; // ROMAN_NUMERAL и заполнитель
+        putVarint(huge, std::uint64_t(1) << 40);
+        std::cout << "Усечённый поток: " << drain(encoded.substr(0, encoded.size() / 2)) << "\n";
+        std::cout << "Короткий заголовок: " << drain("WL") << "\n";
+        std::cout << "Длина строки за концом: " << drain(std::string("WLTS\xF5\x00\xFF\x7F", 8)) << "\n";
+        std::cout << "Огромное римское число: " << drain(huge) << "\n";
+        std::cout << "Целый поток: " << drain(encoded) << "\n\n";
+    }
+
+    // Программа-литерал разобрана при компиляции: ошибка в ней не дала бы собрать файл
+    {
+        std::cout << "=== Разбор во время компиляции ===\n";
+        constexpr auto program = ct::compile<"while (x < V) y := I done; while (y = I) x := XIV done">();
+        static_assert(program.size() == 2 && program.variables.size() == 2);
+        static_assert(program.loops[1].value.value == 14 && program.loops[1].target == 0);
+        // Лексика та же, что у tokenize(): такие литералы не собрались бы
+        static_assert(ct::lexicalError("while (счётчик < X) α := I done") == nullptr);
+        static_assert(ct::lexicalError("while (x—y < I) y := I done") != nullptr);
+        static_assert(ct::lexicalError("while (x < I) \xFF\xFE := I done") != nullptr);
+        static_assert(ct::lexicalError("変数 := I") != nullptr);
+
+        ASTFactory factory;
+        printAST(program.toAST(factory));
+        std::cout << "\n";
+    }
+
+    // Выполнение на виртуальной машине: обычный байткод и суперкоманды
+    {
+        std::cout << "=== Виртуальная машина ===\n";
+        auto ast = LRParser(tokenize("while (x < V) x := X done; while (y < x) y := x done; while (I = I) z := I done")).parse();
+        for (CompileMode mode : {CompileMode::Plain, CompileMode::Super})
+        {
+            Bytecode program = Compiler::compile(ast, mode);
+            std::vector<std::int64_t> env;
+            ExecResult result = execute(program, env, 1000);
+            std::cout << (mode == CompileMode::Plain ? "Обычный байткод: " : "Суперкоманды: ")
+                      << program.code.size() << " команд, выполнено " << result.dispatches
+                      << (result.finished ? "" : " (лимит исчерпан)") << "; x = " << env[0] << ", y = " << env[1] << "\n";
+        }
+        std::cout << "\n";
+    }
+
+    // JIT: та же программа в машинном коде (или интерпретатором вне x86-64)
+    {
+        std::cout << "=== JIT ===\n";
+        auto ast = LRParser(tokenize("while (x < V) x := X done; while (y < x) y := x done; while (I = I) z := I done")).parse();
+        JitProgram jit = JitProgram::compile(ast);
+        std::vector<std::int64_t> env;
+        bool finished = jit.run(env, 1000);
+        std::cout << (jit.native() ? "Машинный код" : "Интерпретатор") << ": "
+                  << (finished ? "завершено" : "лимит исчерпан") << "; x = " << env[0] << ", y = " << env[1] << "\n";
+
+        // Лимит 0 и 1: без итераций и бесконечный цикл — как у интерпретатора;
+        // цикл ровно из одной итерации укладывается в лимит 1, но не в 0
+        int agree = 0, cases = 0;
+        for (const char* source : {"while (V < I) z := I done", "while (I = I) z := I done"})
+        {
+            auto program = LRParser(tokenize(source)).parse();
+            JitProgram compiled = JitProgram::compile(program);
+            Bytecode bytecode = Compiler::compile(program, CompileMode::Super);
+            for (std::uint64_t fuel : {0, 1})
+            {
+                std::vector<std::int64_t> jitEnv, vmEnv;
+                agree += compiled.run(jitEnv, fuel) == execute(bytecode, vmEnv, fuel).finished;
+                cases++;
+            }
+        }
+        JitProgram once = JitProgram::compile(LRParser(tokenize("while (x < V) x := X done")).parse());
+        std::vector<std::int64_t> noFuel, oneIteration;
+        bool exact = !once.run(noFuel, 0) && once.run(oneIteration, 1) && oneIteration[0] == 10;
+        std::cout << "Лимит 0 и 1 как у интерпретатора: " << agree << " из " << cases
+                  << ", одна итерация при лимите 1: " << (exact || !once.native() ? "да" : "нет") << "\n\n";
+    }
+
+    // Число итераций циклов и выполнение в замкнутой форме
+    {
+        std::cout << "=== Анализ числа итераций ===\n";
+        static const char *names[] = {"0", "0 или 1", "0 или бесконечно", "бесконечно", "0, 1 или бесконечно"};
+        auto ast = LRParser(tokenize("while (x < V) x := X done; while (y < x) y := x done; "
+                                     "while (x = y) z := I done; while (z > y) y := w done; while (V < I) z := I done")).parse();
+        auto trips = classifyLoops(ast);
+        for (size_t i = 0; i < trips.size(); ++i)
+        {
+            std::cout << "Цикл " << (i + 1) << ": " << names[static_cast<int>(trips[i])] << "\n";
+        }
+
+        size_t agree = 0, runs = 0;
+        Bytecode closed = Compiler::compile(ast, CompileMode::Closed);
+        Bytecode looping = Compiler::compile(ast, CompileMode::Super);
+        for (int x = 0; x < 12; ++x)
+            for (int y = 0; y < 12; ++y)
+            {
+                std::vector<std::int64_t> a = {x, y, 0, 3}, b = a;
+                ExecResult fast = execute(closed, a);
+                ExecResult slow = execute(looping, b, 1000);
+                agree += fast.finished == slow.finished && (!fast.finished || a == b);
+                runs++;
+            }
+        std::cout << "Замкнутая форма совпала с циклами: " << agree << " из " << runs << "\n";
+
+        auto rejected = LRParser(tokenize("while (x < V) x := X done; while (y = y) x := I done")).parse();
+        std::cout << "Гарантированное зацикливание в цикле: " << findCertainDivergence(rejected) + 1 << "\n\n";
+    }
+
+    // Независимые операторы: множества чтений/записей и параллельное выполнение
+    {
+        std::cout << "=== Параллельное выполнение ===\n";
+        auto ast = LRParser(tokenize("while (x < V) x := X done; while (a < I) a := II done; "
+                                     "while (y < x) y := x done; while (b = I) b := a done")).parse();
+        ParallelProgram program = ParallelProgram::compile(ast);
+        std::cout << "Уровней: " << program.depth() << ", циклы 1 и 2 независимы: "
+                  << (program.independent(0, 1) ? "да" : "нет") << ", циклы 1 и 3: "
+                  << (program.independent(0, 2) ? "да" : "нет") << "\n";
+
+        ThreadPool pool(4);
+        std::vector<std::int64_t> parallelEnv, sequentialEnv;
+        bool finished = program.run(parallelEnv, pool);
+        execute(Compiler::compile(ast, CompileMode::Closed), sequentialEnv);
+        std::cout << "Совпадает с последовательным: "
+                  << (finished && parallelEnv == sequentialEnv ? "да" : "нет") << "\n\n";
+    }
+
+    // Пакетное выполнение одной программы над многими окружениями
+    {
+        std::cout << "=== Пакетное выполнение ===\n";
+        auto ast = LRParser(tokenize("while (x < V) x := X done; while (y < x) y := x done; "
+                                     "while (x = y) z := I done; while (z > y) y := w done")).parse();
+        BatchProgram batch = BatchProgram::compile(ast);
+        Bytecode closed = Compiler::compile(ast, CompileMode::Closed);
+
+        const size_t lanes = 1003;
+        BatchEnv env(lanes, batch.vars().size());
+        for (size_t lane = 0; lane < lanes; ++lane)
+            for (size_t v = 0; v < env.vars(); ++v)
+                env.at(lane, v) = static_cast<std::int32_t>((lane * 7 + v * 13) % 12);
+        BatchEnv initial = env;
+        batch.run(env);
+
+        size_t agree = 0, diverged = 0;
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            std::vector<std::int64_t> one;
+            for (size_t v = 0; v < env.vars(); ++v)
+                one.push_back(initial.at(lane, v));
+            ExecResult result = execute(closed, one);
+            bool same = result.finished != env.diverged(lane);
+            for (size_t v = 0; same && result.finished && v < env.vars(); ++v)
+                same = one[v] == env.at(lane, v);
+            agree += same;
+            diverged += env.diverged(lane);
+        }
+        std::cout << (BatchProgram::vectorized() ? "AVX2" : "Скалярно") << ": совпало " << agree << " из " << lanes
+                  << ", зациклилось " << diverged << "\n";
+
+        BatchEnv narrow(lanes, batch.vars().size() - 1);
+        try
+        {
+            batch.run(narrow);
+            std::cout << "Узкое окружение принято\n\n";
+        }
+        catch (const std::invalid_argument &e)
+        {
+            std::cout << "Узкое окружение отвергнуто: " << e.what() << "\n\n";
+        }
+    }
+
+    // Лексер по таблицам ДКА: самое длинное совпадение и приоритеты
+    {
+        std::cout << "=== Генератор лексера ===\n";
+        auto types = [](const std::string& text) {
+            std::string result;
+            for (const auto& token : tokenize(text))
+            {
+                if (token.type == TokenType::IDENTIFIER) result += "id ";
+                else if (token.type == TokenType::ROMAN_NUMERAL) result += "num ";
+                else if (token.type != TokenType::END) result += token.value + " ";
+            }
+            return result;
+        };
+        std::cout << "whilex := done1 -> " << types("whilex := done1") << "\n";
+        std::cout << "while (XIV < XIVa) IX := x done -> " << types("while (XIV < XIVa) IX := x done") << "\n";
+
+        LexerTables custom = LexerGenerator::build(parseTokenRules("ONE a 1\nMANY a+ 2\nPAIR ab 1\nWORD (a|b)*c 3\n"));
+        auto show = [&](std::string_view text) {
+            auto [rule, length] = custom.match(text);
+            return (rule == -1 ? std::string("нет") : custom.names[rule]) + "/" + std::to_string(length);
+        };
+        std::cout << "a: " << show("a") << ", aaa: " << show("aaa") << ", abx: " << show("abx")
+                  << ", ababc: " << show("ababc") << ", c: " << show("c") << ", x: " << show("x")
+                  << " (состояний " << custom.states() << ")\n\n";
+    }
+
+    // Позиции токенов: смещения в токенах, строка и столбец — по запросу
+    {
+        std::cout << "=== Позиции токенов ===\n";
+        std::string program = "while (x < V)\n  y := I\ndone;\n\nwhile (a = I) b := X done";
+        auto tokens = tokenize(program);
+        LineIndex lines(program);
+        bool exact = true;
+        for (const auto& token : tokens)
+        {
+            exact = exact && program.compare(token.offset, token.value.size(), token.value) == 0;
+            if (token.type == TokenType::DONE)
+            {
+                SourceLocation where = lines.locate(token.offset);
+                std::cout << "done: строка " << where.line << ", столбец " << where.column << "\n";
+            }
+        }
+        std::cout << "Смещения указывают на текст токенов: " << (exact ? "да" : "нет") << "\n";
+
+        std::string text;
+        for (int i = 0; i < 5000; ++i)
+            text += std::string(i * 7919 % 37, 'a') + (i % 5 ? "\n" : "\n\n");
+        LineIndex index(text);
+        size_t agree = 0, queries = 0;
+        for (size_t offset = 0; offset <= text.size(); offset += 97, ++queries)
+        {
+            size_t line = 1 + std::count(text.begin(), text.begin() + offset, '\n');
+            size_t previous = offset == 0 ? std::string::npos : text.rfind('\n', offset - 1);
+            size_t column = previous == std::string::npos ? offset + 1 : offset - previous;
+            SourceLocation where = index.locate(offset);
+            agree += where.line == line && where.column == column;
+        }
+        std::cout << "Строк: " << index.lines() << ", совпало с прямым подсчётом: " << agree << " из " << queries << "\n\n";
+    }
+
+    // UTF-8: проверка кодировки и идентификаторы с буквами вне ASCII
+    {
+        std::cout << "=== UTF-8 и идентификаторы ===\n";
+        std::string program = "while (счётчик < X) счётчик := α done; while (x < V) Größe := IV done";
+        auto tokens = tokenize(program);
+        std::cout << "Токенов: " << tokens.size() << ", идентификаторы:";
+        for (const auto& token : tokens)
+            if (token.type == TokenType::IDENTIFIER)
+                std::cout << " " << token.value;
+        std::cout << "\n";
+        auto ast = LRParser(tokens).parse();
+        std::cout << "Разбор: " << (ast ? "успешно" : "ошибка") << "\n";
+
+        std::cout << "XIVж -> " << (tokenize("XIVж")[0].type == TokenType::IDENTIFIER ? "идентификатор" : "другое") << "\n";
+        size_t broken = tokenize("x := \xD0\x28").size();
+        size_t surrogate = tokenize("x\xED\xA0\x80").size();
+        size_t dash = tokenize("while (x—y < I) y := I done").size();
+        size_t foreign = tokenize("変数 := I").size(); // Не европейский алфавит (isEuropeanLetter)
+        std::cout << "Токенов при неверном UTF-8: " << broken << ", при суррогате: " << surrogate
+                  << ", при не-букве в имени: " << dash << ", при иероглифах: " << foreign << "\n";
+        SourceLocation where = LineIndex("ёж := I\nжук := ёж").locate(std::string("ёж := I\nжук := ").size());
+        std::cout << "ёж во второй строке: строка " << where.line << ", столбец " << where.column << "\n";
+
+        const char* samples[] = {"", "abc", "жёлтый", "\xC0\xAF", "\xE0\x80\xAF", "\xF4\x90\x80\x80", "\xF0\x9F\x98\x80", "ab\xC3"};
+        for (const char* sample : samples) {
+            Utf8Check check = checkUtf8(sample);
+            std::cout << (check.error == std::string_view::npos ? "+" : "-") << (check.ascii ? "a" : "u") << " ";
+        }
+        std::cout << "\n";
+
+        std::string longText(1000, 'x');
+        longText += "я";
+        longText += std::string(100, 'y') + "\xFF";
+        Utf8Check check = checkUtf8(longText);
+        std::cout << "Длинный текст: ошибка в " << check.error << ", ASCII: " << (check.ascii ? "да" : "нет") << "\n\n";
+    }
+
+    // Память на больших страницах и по узлам NUMA: токены и узлы AST в арене
+    {
+        std::cout << "=== Арена на больших страницах ===\n";
+        std::string program;
+        for (int i = 0; i < 200; ++i)
+            program += std::string(i ? "; " : "") + "while (v" + std::to_string(i % 300) + " < XIV) w" +
+                       std::to_string(i % 7) + " := I done";
+
+        HugePageArena arena({MemoryPolicy::Pages::Transparent, MemoryPolicy::AnyNode}, 1 << 20);
+        auto inArena = std::make_shared<ASTFactory>(&arena);
+        auto tokens = tokenize(program, &arena);
+        bool sameTokens = tokens.size() == tokenize(program).size() && tokens.get_allocator().resource() == &arena;
+        auto ast = LRParser(std::move(tokens), inArena).parse();
+        auto reference = LRParser(tokenize(program)).parse();
+        const auto& stats = arena.stats();
+        std::cout << "Токены в арене: " << (sameTokens ? "да" : "нет") << ", AST совпадает: "
+                  << (sameTree(ast, reference) ? "да" : "нет") << ", узлов: " << inArena->size() << "\n";
+        std::cout << "Блоки по 2 МиБ: " << (stats.blocks > 0 && stats.mapped % HugePageArena::HugePage == 0 ? "да" : "нет")
+                  << ", выдано не больше полученного: " << (stats.used <= stats.mapped ? "да" : "нет") << "\n";
+
+        HugePageArena aligned({MemoryPolicy::Pages::Normal, MemoryPolicy::AnyNode});
+        void* a = aligned.allocate(3, 1);
+        void* b = aligned.allocate(64, 64);
+        void* big = aligned.allocate(40 << 20, 4096);
+        std::cout << "Выравнивание 64: " << (reinterpret_cast<std::uintptr_t>(b) % 64 == 0 ? "да" : "нет")
+                  << ", после 3 байтов: " << (static_cast<char*>(b) >= static_cast<char*>(a) + 3 ? "да" : "нет")
+                  << ", блок 40 МиБ отдельно: " << (aligned.stats().blocks == 2 && big ? "да" : "нет") << "\n";
+
+        // Явные большие страницы: при пустом пуле hugetlbfs — откат на обычное отображение
+        HugePageArena explicitPages({MemoryPolicy::Pages::Explicit, MemoryPolicy::AnyNode});
+        auto* numbers = static_cast<int*>(explicitPages.allocate(1000 * sizeof(int), alignof(int)));
+        numbers[999] = 7;
+        std::cout << "MAP_HUGETLB с откатом: записано " << numbers[999] << "\n";
+
+        // Задания рабочего потока: после release() второе задание берёт те же блоки
+        size_t mappedAfter[2] = {}, treeNodes[2] = {};
+        const Token* tokenData[2] = {};
+        for (int job = 0; job < 2; ++job) {
+            ArenaJob scope;
+            auto factory = std::make_shared<ASTFactory>(&scope.memory());
+            auto jobTokens = tokenize(program, &scope.memory());
+            tokenData[job] = jobTokens.data();
+            auto tree = LRParser(std::move(jobTokens), factory).parse();
+            treeNodes[job] = sameTree(tree, reference) ? factory->size() : 0;
+            mappedAfter[job] = scope.memory().stats().mapped;
+        }
+        // Вложенное задание не освобождает память внешнего
+        bool nestedKept = false;
+        {
+            ArenaJob outer;
+            auto outerTokens = tokenize(program, &outer.memory());
+            {
+                ArenaJob inner;
+                tokenize("x := I", &inner.memory());
+            }
+            auto later = tokenize(program, &outer.memory());
+            nestedKept = outerTokens.data() + outerTokens.size() <= later.data() &&
+                         outerTokens.back().type == TokenType::END && outerTokens[0].value == "while";
+        }
+        bool exactReserve = tokenize("x:=I;y:=V", &arena).capacity() == tokenize("x:=I;y:=V").size();
+
+        std::cout << "Два задания в арене потока: узлов " << treeNodes[0] << " и " << treeNodes[1]
+                  << ", память переиспользована: "
+                  << (tokenData[1] == tokenData[0] && mappedAfter[1] == mappedAfter[0] ? "да" : "нет")
+                  << ", на узле потока: " << (workerArena().node() == currentNumaNode() ? "да" : "нет") << "\n";
+        std::cout << "Вложенное задание сохранило память внешнего: " << (nestedKept ? "да" : "нет")
+                  << ", резерв токенов точный: " << (exactReserve ? "да" : "нет") << "\n\n";
+    }
+
+    // Узлы AST фиксированной арности: дети хранятся в самом узле
+    {
+        std::cout << "=== Дети внутри узлов ===\n";
+        auto ast = LRParser(tokenize("while (x < V) y := I done; while (a = X) b := x done")).parse();
+        size_t inside = 0, fixed = 0, total = 0;
+        std::function<void(const std::shared_ptr<ASTNode>&)> walk = [&](const std::shared_ptr<ASTNode>& node) {
+            total++;
+            if (node->type != "StatementList") {
+                auto begin = reinterpret_cast<const char*>(node.get());
+                auto data = reinterpret_cast<const char*>(node->children.data());
+                fixed++;
+                inside += node->children.empty() || (data > begin && data < begin + sizeof(FixedNode<3>));
+            }
+            for (const auto& child : node->children) walk(child);
+        };
+        walk(ast);
+        const auto& list = ast->children[0];
+        std::cout << "Узлов: " << total << ", фиксированной арности: " << fixed << ", дети в самом узле: " << inside
+                  << "\nStatementList — список: " << (static_cast<const ListNode&>(*list).items.data() == list->children.data() ? "да" : "нет")
+                  << ", операторов " << list->children.size() << "\n";
+
+        ASTFactory factory;
+        auto x = factory.make("Identifier", "x"), one = factory.make("RomanNumeral", "I");
+        auto first = factory.make("Assignment", "", {factory.make("LValue", "x"), one});
+        auto second = factory.make("Assignment", "", {factory.make("LValue", "x"), one});
+        auto wide = factory.make("Tuple", "", {x, one, x, one});
+        std::cout << "Повторный узел разделяется: " << (first == second ? "да" : "нет") << ", арность 4 — список: "
+                  << (static_cast<const ListNode&>(*wide).items.data() == wide->children.data() ? "да" : "нет")
+                  << ", размер узла с 3 детьми: " << sizeof(FixedNode<3>) << " байт\n\n";
+    }
+
     return 0;
 }
\ No newline at end of file
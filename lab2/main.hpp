@@ -1,8 +1,21 @@
+#pragma once
+
 #include <iostream>
 #include <vector>
 #include <string>
-#include <cctype>
+#include <string_view>
 #include <memory>
+#include <memory_resource>
+#include <array>
+#include <span>
+#include <initializer_list>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 /// Типы лексем, распознаваемые анализатором.
 enum class TokenType {
@@ -15,175 +28,590 @@ enum class TokenType {
 struct Token {
     TokenType type;      ///< Тип токена (например, IDENTIFIER, WHILE).
     std::string value;   ///< Строковое содержимое токена.
-    Token(TokenType t, std::string v) : type(t), value(std::move(v)) {}
+    std::size_t offset;  ///< Смещение первого байта токена в исходном тексте (0, если текста нет).
+    Token(TokenType t, std::string v, std::size_t o = 0) : type(t), value(std::move(v)), offset(o) {}
+};
+
+/// Строка и столбец (с единицы; столбец — в символах UTF-8) позиции в исходном тексте.
+struct SourceLocation {
+    std::size_t line;
+    std::size_t column;
+};
+
+/// Перевод смещений в строку и столбец для диагностики и инструментов.
+/// Лексер хранит в токенах только смещения; индекс начал строк строится
+/// при первом запросе одним проходом по тексту (SSE2: поиск '\n' по 16 байт),
+/// после чего каждый запрос — двоичный поиск. Текст должен жить дольше индекса.
+/// Ленивое построение не синхронизировано: общий индекс из нескольких потоков
+/// нужно сначала построить явным вызовом lines().
+class LineIndex {
+    std::string_view text;
+    mutable std::vector<std::size_t> starts; ///< Смещения начал строк.
+    mutable bool built = false;
+
+    void build() const {
+        starts.assign(1, 0);
+        const char* data = text.data();
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        const __m128i newline = _mm_set1_epi8('\n');
+        for (; i + 16 <= text.size(); i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            for (unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)); mask; mask &= mask - 1)
+                starts.push_back(i + __builtin_ctz(mask) + 1);
+        }
+#endif
+        for (; i < text.size(); ++i)
+            if (data[i] == '\n') starts.push_back(i + 1);
+        built = true;
+    }
+
+public:
+    explicit LineIndex(std::string_view source) : text(source) {}
+
+    /// Число строк текста (строит индекс).
+    std::size_t lines() const {
+        if (!built) build();
+        return starts.size();
+    }
+
+    /// Строка и столбец байта offset (offset == размер текста — позиция конца).
+    SourceLocation locate(std::size_t offset) const {
+        if (!built) build();
+        auto line = std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin();
+        // Столбец считается в символах UTF-8: продолжающие байты 10xxxxxx не учитываются
+        std::size_t column = 1;
+        for (std::size_t k = starts[line - 1]; k < offset && k < text.size(); ++k)
+            column += (static_cast<unsigned char>(text[k]) & 0xC0) != 0x80;
+        return {static_cast<std::size_t>(line), column};
+    }
 };
 
 /// Проверяет, является ли символ допустимым в римском числе (I, V, X).
-bool isRomanChar(char c) {
+constexpr bool isRomanChar(char c) {
     return c == 'I' || c == 'V' || c == 'X';
 }
 
-/// Выполняет лексический анализ: разбивает строку на токены.
-std::vector<Token> tokenize(const std::string& input) {
-    std::vector<Token> tokens;
+/// Пробельный символ (как std::isspace в локали "C", но пригоден для constexpr).
+constexpr bool isSpaceChar(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+/// Латинская буква (как std::isalpha в локали "C").
+constexpr bool isAlphaChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/// Латинская буква или цифра (как std::isalnum в локали "C").
+constexpr bool isAlnumChar(char c) {
+    return isAlphaChar(c) || (c >= '0' && c <= '9');
+}
+
+/// Результат проверки кодировки UTF-8.
+struct Utf8Check {
+    std::size_t error = std::string_view::npos; ///< Смещение первого неверного байта (npos — ошибок нет).
+    bool ascii = true;                          ///< Во входе только байты ASCII.
+};
+
+/// Длина последовательности UTF-8, начинающейся в позиции i, или 0, если она
+/// неверна: обрыв, лишний продолжающий байт, избыточная запись, суррогат или
+/// код больше U+10FFFF.
+constexpr std::size_t utf8Length(std::string_view s, std::size_t i) {
+    auto byte = [&](std::size_t k) { return static_cast<unsigned char>(s[k]); };
+    unsigned char lead = byte(i);
+    std::size_t length = lead < 0x80 ? 1 : lead < 0xC2 ? 0 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : lead < 0xF5 ? 4 : 0;
+    if (length == 0 || i + length > s.size()) return 0;
+    for (std::size_t k = 1; k < length; ++k)
+        if ((byte(i + k) & 0xC0) != 0x80) return 0;
+    if (length == 3) {
+        unsigned char second = byte(i + 1);
+        if ((lead == 0xE0 && second < 0xA0) || (lead == 0xED && second >= 0xA0)) return 0;
+    }
+    if (length == 4) {
+        unsigned char second = byte(i + 1);
+        if ((lead == 0xF0 && second < 0x90) || (lead == 0xF4 && second >= 0x90)) return 0;
+    }
+    return length;
+}
+
+/// Проверяет, что текст — корректный UTF-8. Участки ASCII (почти весь вход
+/// в программах на этом языке) пропускаются по 16 байтов за сравнение (SSE2),
+/// многобайтовые последовательности разбираются по одной.
+Utf8Check checkUtf8(std::string_view text) {
+    Utf8Check result;
+    const char* data = text.data();
+    std::size_t i = 0;
+    while (i < text.size()) {
+#if defined(__SSE2__)
+        while (i + 16 <= text.size() &&
+               _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))) == 0)
+            i += 16;
+        if (i == text.size()) break;
+#endif
+        if (static_cast<unsigned char>(data[i]) < 0x80) { ++i; continue; }
+        result.ascii = false;
+        std::size_t length = utf8Length(text, i);
+        if (length == 0) {
+            result.error = i;
+            break;
+        }
+        i += length;
+    }
+    return result;
+}
+
+/// Код символа из корректной последовательности UTF-8 в позиции i; i сдвигается за неё.
+constexpr char32_t decodeUtf8(std::string_view s, std::size_t& i) {
+    auto byte = [&](std::size_t k) { return static_cast<char32_t>(static_cast<unsigned char>(s[k])); };
+    char32_t lead = byte(i);
+    if (lead < 0x80) { ++i; return lead; }
+    std::size_t length = lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+    char32_t code = lead & (0x7F >> length);
+    for (std::size_t k = 1; k < length; ++k) code = (code << 6) | (byte(i + k) & 0x3F);
+    i += length;
+    return code;
+}
+
+/// Буква вне ASCII, допустимая в идентификаторе. Это не полная категория
+/// букв Unicode, а только европейские алфавиты: латиница с диакритикой
+/// (Latin-1, Latin Extended-A/B), греческий алфавит и кириллица. Буквы
+/// других письменностей (армянской, арабской, CJK и т. д.) отвергаются.
+constexpr bool isEuropeanLetter(char32_t c) {
+    return (c >= 0xC0 && c <= 0x24F && c != 0xD7 && c != 0xF7) ||
+           (c >= 0x386 && c <= 0x3FF && c != 0x387 && c != 0x3F6) ||
+           (c >= 0x400 && c <= 0x52F && (c < 0x482 || c > 0x489));
+}
+
+/// Позиция первого символа вне ASCII в идентификаторе, не являющегося буквой
+/// европейского алфавита (isEuropeanLetter), или npos.
+constexpr std::size_t findNonLetter(std::string_view identifier) {
+    for (std::size_t i = 0; i < identifier.size();) {
+        std::size_t at = i;
+        char32_t c = decodeUtf8(identifier, i);
+        if (c >= 0x80 && !isEuropeanLetter(c)) return at;
+    }
+    return std::string_view::npos;
+}
+
+/// Значение римского числа из символов I, V, X (меньшая цифра перед большей вычитается).
+constexpr int romanToInt(std::string_view s) {
+    auto digit = [](char c) { return c == 'I' ? 1 : c == 'V' ? 5 : 10; };
+    int result = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        int d = digit(s[i]);
+        result += (i + 1 < s.size() && d < digit(s[i + 1])) ? -d : d;
+    }
+    return result;
+}
+
+/// Каноническая запись неотрицательного числа римскими цифрами I, V, X (десятки — повтором X).
+std::string intToRoman(int n) {
+    static const char* units[] = {"", "I", "II", "III", "IV", "V", "VI", "VII", "VIII", "IX"};
+    return std::string(n / 10, 'X') + units[n % 10];
+}
+
+/// Лексема, распознанная в позиции входной строки.
+struct Lexeme {
+    TokenType type;      ///< Тип токена.
+    size_t length;       ///< Длина в байтах; 0 — недопустимый символ.
+};
+
+// Таблицы лексера генерируются lexgen.exe из tokens.lex (см. Makefile)
+#include "lexer_tables.hpp"
+
+/// Распознаёт одну лексему, начинающуюся в позиции i (input[i] — не пробел):
+/// самое длинное совпадение по таблицам минимального ДКА всех лексем, при равной
+/// длине — лексема с меньшим приоритетом в tokens.lex. Поэтому «whilex» —
+/// идентификатор, а не while и x. Функция constexpr, поэтому её используют
+/// и tokenize(), и лексер времени компиляции.
+constexpr Lexeme scanToken(std::string_view input, size_t i) {
+    Lexeme best{TokenType::END, 0};
+    unsigned row = lextab::lexStart;
+    for (size_t j = i; j < input.size(); ++j) {
+        row = lextab::lexNext[row + lextab::lexClass[static_cast<unsigned char>(input[j])]];
+        if (row == 0) break;
+        TokenType type = lextab::lexAccept[row / lextab::lexStride];
+        if (type != TokenType::END) {
+            best = {type, j - i + 1};
+            if (lextab::lexFinal[row / lextab::lexStride]) break;
+        }
+    }
+    return best;
+}
+
+/// Разбивает строку на токены в пустой массив tokens (std::vector или
+/// std::pmr::vector); при ошибке массив остаётся пустым. См. tokenize().
+template <typename Tokens>
+void tokenizeInto(const std::string& input, Tokens& tokens) {
     size_t i = 0;
 
+    auto lexicalError = [&](size_t at) {
+        SourceLocation where = LineIndex(input).locate(at);
+        size_t length = utf8Length(input, at);
+        std::cerr << "Ошибка лексики: недопустимый символ '" << input.substr(at, length ? length : 1)
+                  << "' (строка " << where.line << ", столбец " << where.column << ")\n";
+    };
+    Utf8Check encoding = checkUtf8(input);
+    if (encoding.error != std::string_view::npos) {
+        SourceLocation where = LineIndex(input).locate(encoding.error);
+        std::cerr << "Ошибка лексики: неверная последовательность UTF-8 (строка " << where.line
+                  << ", столбец " << where.column << ")\n";
+        tokens.clear();
+        return;
+    }
+
     while (i < input.length()) {
         char c = input[i];
-        if (std::isspace(c)) { i++; continue; }
-
-        if (input.substr(i, 5) == "while") {
-            tokens.emplace_back(TokenType::WHILE, "while");
-            i += 5;
-        } else if (input.substr(i, 4) == "done") {
-            tokens.emplace_back(TokenType::DONE, "done");
-            i += 4;
-        } else if (c == ';') {
-            tokens.emplace_back(TokenType::SEMICOLON, ";");
-            i++;
-        } else if (c == '(') {
-            tokens.emplace_back(TokenType::LPAREN, "(");
-            i++;
-        } else if (c == ')') {
-            tokens.emplace_back(TokenType::RPAREN, ")");
-            i++;
-        } else if (i + 1 < input.length() && input.substr(i, 2) == ":=") {
-            tokens.emplace_back(TokenType::ASSIGN, ":=");
-            i += 2;
-        } else if (c == '<') {
-            tokens.emplace_back(TokenType::LESS, "<");
-            i++;
-        } else if (c == '>') {
-            tokens.emplace_back(TokenType::GREATER, ">");
-            i++;
-        } else if (c == '=') {
-            tokens.emplace_back(TokenType::EQUAL, "=");
-            i++;
-        } else if (std::isalpha(c)) {
-            size_t start = i;
-            while (i < input.length() && std::isalnum(input[i])) i++;
-            std::string word = input.substr(start, i - start);
-
-            bool isRoman = !word.empty();
-            for (char ch : word) {
-                if (!isRomanChar(ch)) {
-                    isRoman = false;
-                    break;
-                }
-            }
+        if (isSpaceChar(c)) { i++; continue; }
 
-            tokens.emplace_back(isRoman ? TokenType::ROMAN_NUMERAL : TokenType::IDENTIFIER, word);
-        } else {
-            std::cerr << "Ошибка лексики: недопустимый символ '" << c << "'\n";
-            return {};
+        Lexeme lexeme = scanToken(input, i);
+        if (lexeme.length == 0) {
+            lexicalError(i);
+            tokens.clear();
+            return;
+        }
+        if (!encoding.ascii && lexeme.type == TokenType::IDENTIFIER) {
+            size_t bad = findNonLetter(std::string_view(input).substr(i, lexeme.length));
+            if (bad != std::string_view::npos) {
+                lexicalError(i + bad);
+                tokens.clear();
+                return;
+            }
         }
+        tokens.emplace_back(lexeme.type, input.substr(i, lexeme.length), i);
+        i += lexeme.length;
+    }
+
+    tokens.emplace_back(TokenType::END, "", input.size());
+}
+
+/// Выполняет лексический анализ: разбивает строку на токены.
+/// Вход должен быть в UTF-8; идентификаторы могут содержать буквы европейских
+/// алфавитов вне ASCII (см. isEuropeanLetter). Если вход целиком ASCII, символы идентификаторов
+/// не декодируются.
+std::vector<Token> tokenize(const std::string& input) {
+    std::vector<Token> tokens;
+    tokenizeInto(input, tokens);
+    return tokens;
+}
+
+/// Число лексем во входе (до первой недопустимой), без завершающего END.
+constexpr size_t countLexemes(std::string_view input) {
+    size_t count = 0;
+    for (size_t i = 0; i < input.size();) {
+        if (isSpaceChar(input[i])) { i++; continue; }
+        size_t length = scanToken(input, i).length;
+        if (length == 0) break;
+        i += length;
+        count++;
     }
+    return count;
+}
 
-    tokens.emplace_back(TokenType::END, "");
+/// То же, но массив токенов размещается в memory (например, в HugePageArena
+/// на больших страницах для многогигабайтных входов). Токены сначала
+/// считаются (countLexemes), и массив резервируется точно: арена не
+/// освобождает старых буферов, так что рост удвоением оставил бы в ней копии.
+std::pmr::vector<Token> tokenize(const std::string& input, std::pmr::memory_resource* memory) {
+    std::pmr::vector<Token> tokens(memory);
+    tokens.reserve(countLexemes(input) + 1);
+    tokenizeInto(input, tokens);
     return tokens;
 }
 
+/// Перемешивает значение v с накопленным хешем seed (финализатор splitmix64).
+inline std::size_t hashCombine(std::size_t seed, std::size_t v) {
+    std::uint64_t x = seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<std::size_t>(x ^ (x >> 31));
+}
+
+struct ListNode;
+
 /// Узел дерева абстрактного синтаксического разбора (AST).
+/// Почти у всех узлов число детей фиксировано (Condition — 3, Assignment и
+/// WhileLoop — 2, Program — 1, листья — 0), и дети хранятся в самом узле
+/// (FixedNode); список произвольной длины — только у StatementList (ListNode).
+/// children — вид на это хранилище, поэтому узел вместе со счётчиком ссылок
+/// создаётся одним выделением памяти, а обход не уходит в отдельный буфер.
 struct ASTNode {
     std::string type;    ///< Тип узла (например, "WhileLoop", "Assignment").
     std::string value;   ///< Значение узла (для листьев: имя или число).
-    std::vector<std::shared_ptr<ASTNode>> children; ///< Дочерние узлы.
-    ASTNode(std::string t, std::string v = "") : type(std::move(t)), value(std::move(v)) {}
+    std::span<const std::shared_ptr<ASTNode>> children; ///< Дочерние узлы (хранятся в самом узле).
+    std::size_t hash = 0; ///< Структурный хеш поддерева (заполняется ASTFactory).
+    const ListNode* list = nullptr; ///< Этот же узел, если он — ListNode.
+
+    ASTNode(const ASTNode&) = delete;
+    ASTNode& operator=(const ASTNode&) = delete;
+
+protected:
+    ASTNode(std::string t, std::string v) : type(std::move(t)), value(std::move(v)) {}
+};
+
+/// Узел с N детьми, хранящимися внутри него.
+template <size_t N>
+struct FixedNode : ASTNode {
+    std::array<std::shared_ptr<ASTNode>, N> slots;
+
+    FixedNode(std::string t, std::string v, std::initializer_list<std::shared_ptr<ASTNode>> c)
+        : ASTNode(std::move(t), std::move(v)) {
+        std::copy(c.begin(), c.end(), slots.begin());
+        children = slots;
+    }
+};
+
+/// Узел со списком детей произвольной длины (StatementList).
+struct ListNode : ASTNode {
+    std::vector<std::shared_ptr<ASTNode>> items;
+    /// Накопленные хеши первых и последних k детей (k = 0..n): общие префикс
+    /// и суффикс двух списков находятся двоичным поиском (см. ASTDiff).
+    std::vector<std::size_t> prefixHash, suffixHash;
+
+    ListNode(std::string t, std::string v, std::vector<std::shared_ptr<ASTNode>> c)
+        : ASTNode(std::move(t), std::move(v)), items(std::move(c)), prefixHash(items.size() + 1),
+          suffixHash(items.size() + 1) {
+        children = items;
+        list = this;
+        for (size_t k = 0; k < items.size(); ++k) {
+            prefixHash[k + 1] = hashCombine(prefixHash[k], items[k]->hash);
+            suffixHash[k + 1] = hashCombine(suffixHash[k], items[items.size() - 1 - k]->hash);
+        }
+    }
+};
+
+/// Фабрика узлов с хеш-консингом: структурно одинаковые поддеревья создаются
+/// один раз и разделяются, так что AST превращается в DAG. Узлы, выданные
+/// фабрикой, нельзя изменять — они могут входить в несколько поддеревьев.
+class ASTFactory {
+    std::pmr::memory_resource* memory; ///< Откуда берутся узлы и таблица.
+    std::pmr::unordered_multimap<std::size_t, std::shared_ptr<ASTNode>> table; ///< Хеш -> уникальный узел.
+    std::size_t requests = 0; ///< Сколько узлов было запрошено (с учётом повторов).
+
+    /// Создаёт узел типа Node в памяти фабрики и заносит его в таблицу.
+    template <typename Node, typename... Args>
+    std::shared_ptr<ASTNode> create(std::size_t h, Args&&... args) {
+        std::shared_ptr<ASTNode> node =
+            std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>(memory), std::forward<Args>(args)...);
+        node->hash = h;
+        table.emplace(h, node);
+        return node;
+    }
+
+    /// Считает хеш узла и ищет уже созданный такой же (nullptr, если его нет).
+    std::shared_ptr<ASTNode> find(const std::string& type, const std::string& value,
+                                  std::span<const std::shared_ptr<ASTNode>> children, std::size_t& h) {
+        requests++;
+        h = hashCombine(std::hash<std::string>{}(type), std::hash<std::string>{}(value));
+        for (const auto& child : children) h = hashCombine(h, child->hash);
+
+        auto range = table.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it) {
+            const ASTNode& cand = *it->second;
+            if (cand.type == type && cand.value == value &&
+                std::equal(cand.children.begin(), cand.children.end(), children.begin(), children.end())) {
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+
+public:
+    /// memory — ресурс для узлов (например, HugePageArena рабочего потока);
+    /// он должен жить дольше всех узлов, выданных фабрикой.
+    explicit ASTFactory(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : memory(memory), table(memory) {}
+
+    /// Возвращает узел с заданными типом, значением и детьми; если такой уже
+    /// создавался, возвращает существующий. Дети должны быть выданы этой же фабрикой,
+    /// поэтому их достаточно сравнивать по указателю. Дети (до трёх) хранятся в узле.
+    std::shared_ptr<ASTNode> make(const std::string& type, const std::string& value = "",
+                                  std::initializer_list<std::shared_ptr<ASTNode>> children = {}) {
+        std::size_t h;
+        if (auto node = find(type, value, {children.begin(), children.size()}, h)) return node;
+        switch (children.size()) {
+        case 0: return create<FixedNode<0>>(h, type, value, children);
+        case 1: return create<FixedNode<1>>(h, type, value, children);
+        case 2: return create<FixedNode<2>>(h, type, value, children);
+        case 3: return create<FixedNode<3>>(h, type, value, children);
+        default: return create<ListNode>(h, type, value, std::vector<std::shared_ptr<ASTNode>>(children));
+        }
+    }
+
+    /// То же для списка произвольной длины (StatementList).
+    std::shared_ptr<ASTNode> make(const std::string& type, const std::string& value,
+                                  std::vector<std::shared_ptr<ASTNode>> children) {
+        std::size_t h;
+        if (auto node = find(type, value, children, h)) return node;
+        return create<ListNode>(h, type, value, std::move(children));
+    }
+
+    /// Число уникальных узлов, хранимых фабрикой.
+    std::size_t size() const { return table.size(); }
+
+    /// Общее число запросов make(), т.е. размер AST без разделения поддеревьев.
+    std::size_t requested() const { return requests; }
+};
+
+/// Структурное равенство поддеревьев. Для узлов одной фабрики сводится к
+/// сравнению указателей; при совпадении хешей узлов разных фабрик
+/// выполняется полная проверка.
+bool sameTree(const std::shared_ptr<ASTNode>& a, const std::shared_ptr<ASTNode>& b) {
+    if (a == b) return true;
+    if (!a || !b || a->hash != b->hash) return false;
+    if (a->type != b->type || a->value != b->value || a->children.size() != b->children.size()) return false;
+    for (size_t i = 0; i < a->children.size(); ++i) {
+        if (!sameTree(a->children[i], b->children[i])) return false;
+    }
+    return true;
+}
+
+/// Источник лексем, из которого синтаксический анализатор читает поток по одной.
+struct TokenSource {
+    virtual ~TokenSource() = default;
+    /// Возвращает следующий токен; по окончании потока возвращает END.
+    virtual Token next() = 0;
+};
+
+/// Источник лексем поверх готового списка токенов (результата tokenize()).
+template <typename Tokens = std::vector<Token>>
+class VectorTokenSource : public TokenSource {
+    Tokens tokens;
+    size_t pos = 0;
+
+public:
+    explicit VectorTokenSource(Tokens t) : tokens(std::move(t)) {}
+
+    Token next() override {
+        if (pos < tokens.size()) return std::move(tokens[pos++]);
+        return Token(TokenType::END, "");
+    }
 };
 
 /// Синтаксический анализатор, строящий AST по потоку токенов.
 class LRParser {
-    std::vector<Token> tokens; ///< Список токенов после лексического анализа.
-    size_t pos = 0;            ///< Текущая позиция в списке токенов.
+    std::shared_ptr<TokenSource> owned; ///< Источник, созданный самим анализатором (если есть).
+    TokenSource* source;       ///< Откуда читаются токены.
+    Token lookahead;           ///< Текущий (ещё не потреблённый) токен.
+    std::shared_ptr<ASTFactory> factory; ///< Фабрика узлов (общие поддеревья разделяются).
+    const LineIndex* lines = nullptr; ///< Индекс строк исходного текста для сообщений об ошибках.
 
     /// Возвращает текущий токен без продвижения.
-    const Token& current() const { return tokens[pos]; }
+    const Token& current() const { return lookahead; }
+
+    /// Переходит к следующему токену.
+    void advance() { lookahead = source->next(); }
+
+    /// Сообщает об ошибке в позиции текущего токена и завершает программу.
+    [[noreturn]] void fail(const char* message) const {
+        std::cerr << message;
+        if (lines) {
+            SourceLocation where = lines->locate(current().offset);
+            std::cerr << " (строка " << where.line << ", столбец " << where.column << ")";
+        } else {
+            std::cerr << " (байт " << current().offset << ")";
+        }
+        std::cerr << "\n";
+        exit(1);
+    }
 
     /// Потребляет ожидаемый токен; завершает программу при несоответствии.
     void consume(TokenType expected) {
-        if (current().type != expected) {
-            std::cerr << "Синтаксическая ошибка\n";
-            exit(1);
-        }
-        pos++;
+        if (current().type != expected) fail("Синтаксическая ошибка");
+        advance();
     }
 
     /// Анализирует список операторов, разделённых ';'.
     std::shared_ptr<ASTNode> parseStatementList() {
-        auto node = std::make_shared<ASTNode>("StatementList");
-        node->children.push_back(parseStatement());
+        std::vector<std::shared_ptr<ASTNode>> statements;
+        statements.push_back(parseStatement());
         while (current().type == TokenType::SEMICOLON) {
             consume(TokenType::SEMICOLON);
-            node->children.push_back(parseStatement());
+            statements.push_back(parseStatement());
         }
-        return node;
+        return factory->make("StatementList", "", std::move(statements));
     }
 
     /// Анализирует один оператор цикла: while (...) ... done.
     std::shared_ptr<ASTNode> parseStatement() {
         consume(TokenType::WHILE);
-        auto loop = std::make_shared<ASTNode>("WhileLoop");
         consume(TokenType::LPAREN);
-        loop->children.push_back(parseCondition());
+        auto cond = parseCondition();
         consume(TokenType::RPAREN);
-        loop->children.push_back(parseBody());
+        auto body = parseBody();
         consume(TokenType::DONE);
-        return loop;
+        return factory->make("WhileLoop", "", {cond, body});
     }
 
     /// Анализирует условие цикла: выражение оператор_сравнения выражение.
     std::shared_ptr<ASTNode> parseCondition() {
-        auto cond = std::make_shared<ASTNode>("Condition");
-        cond->children.push_back(parseExpression());
+        auto lhs = parseExpression();
 
+        std::shared_ptr<ASTNode> op;
         if (current().type == TokenType::LESS || current().type == TokenType::GREATER || current().type == TokenType::EQUAL) {
-            cond->children.push_back(std::make_shared<ASTNode>("RelOp", current().value));
-            pos++;
+            op = factory->make("RelOp", current().value);
+            advance();
         } else {
-            std::cerr << "Ожидался оператор сравнения\n";
-            exit(1);
+            fail("Ожидался оператор сравнения");
         }
 
-        cond->children.push_back(parseExpression());
-        return cond;
+        auto rhs = parseExpression();
+        return factory->make("Condition", "", {lhs, op, rhs});
     }
 
     /// Анализирует тело цикла — одно присваивание: id := выражение.
     std::shared_ptr<ASTNode> parseBody() {
-        auto assign = std::make_shared<ASTNode>("Assignment");
-        assign->children.push_back(std::make_shared<ASTNode>("LValue", current().value));
+        auto target = factory->make("LValue", current().value);
         consume(TokenType::IDENTIFIER);
         consume(TokenType::ASSIGN);
-        assign->children.push_back(parseExpression());
-        return assign;
+        auto expr = parseExpression();
+        return factory->make("Assignment", "", {target, expr});
     }
 
     /// Анализирует выражение: идентификатор или римское число.
     std::shared_ptr<ASTNode> parseExpression() {
         if (current().type == TokenType::IDENTIFIER) {
-            auto node = std::make_shared<ASTNode>("Identifier", current().value);
+            auto node = factory->make("Identifier", current().value);
             consume(TokenType::IDENTIFIER);
             return node;
         } else if (current().type == TokenType::ROMAN_NUMERAL) {
-            auto node = std::make_shared<ASTNode>("RomanNumeral", current().value);
+            auto node = factory->make("RomanNumeral", current().value);
             consume(TokenType::ROMAN_NUMERAL);
             return node;
         } else {
-            std::cerr << "Ожидалось выражение\n";
-            exit(1);
+            fail("Ожидалось выражение");
         }
     }
 
 public:
-    /// Конструктор: принимает токены от лексера.
-    LRParser(std::vector<Token> t) : tokens(std::move(t)) {}
+    /// Конструктор: принимает токены от лексера. Фабрику можно передать явно,
+    /// чтобы разделять поддеревья между несколькими программами.
+    LRParser(std::vector<Token> t, std::shared_ptr<ASTFactory> f = nullptr)
+        : owned(std::make_shared<VectorTokenSource<>>(std::move(t))), source(owned.get()),
+          lookahead(source->next()), factory(f ? std::move(f) : std::make_shared<ASTFactory>()) {}
+
+    /// Конструктор для токенов в пользовательской памяти (tokenize(input, memory)).
+    LRParser(std::pmr::vector<Token> t, std::shared_ptr<ASTFactory> f = nullptr)
+        : owned(std::make_shared<VectorTokenSource<std::pmr::vector<Token>>>(std::move(t))), source(owned.get()),
+          lookahead(source->next()), factory(f ? std::move(f) : std::make_shared<ASTFactory>()) {}
+
+    /// Конструктор для потокового разбора: токены читаются из src по мере
+    /// надобности (src должен существовать до конца разбора).
+    LRParser(TokenSource& src, std::shared_ptr<ASTFactory> f = nullptr)
+        : source(&src), lookahead(source->next()), factory(f ? std::move(f) : std::make_shared<ASTFactory>()) {}
 
     /// Запускает разбор всей программы и возвращает корень AST.
     std::shared_ptr<ASTNode> parse() {
-        auto root = std::make_shared<ASTNode>("Program");
-        root->children.push_back(parseStatementList());
-        return root;
+        auto list = parseStatementList();
+        return factory->make("Program", "", {list});
     }
+
+    /// Сообщения об ошибках будут указывать строку и столбец по индексу index
+    /// исходного текста (иначе — смещение в байтах).
+    void locateErrors(const LineIndex& index) { lines = &index; }
+
+    /// Фабрика, в которой хранятся узлы построенного AST.
+    const ASTFactory& nodes() const { return *factory; }
 };
 
 /// Рекурсивно выводит AST с отступами для наглядности.
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "vm.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/// Множество переменных: битовое множество над номерами из VarTable.
+/// Хранятся только ненулевые 64-битные слова (номер слова, биты) по возрастанию
+/// номера, так что оператору с тремя переменными хватает трёх слов даже
+/// в программе с миллионом переменных.
+class VarSet {
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> words;
+
+public:
+    void insert(std::uint32_t id) {
+        std::uint32_t index = id / 64;
+        std::uint64_t bit = std::uint64_t(1) << (id % 64);
+        auto it = std::lower_bound(words.begin(), words.end(), index,
+                                   [](const auto& w, std::uint32_t i) { return w.first < i; });
+        if (it != words.end() && it->first == index) it->second |= bit;
+        else words.insert(it, {index, bit});
+    }
+
+    bool contains(std::uint32_t id) const {
+        for (const auto& w : words)
+            if (w.first == id / 64) return w.second >> (id % 64) & 1;
+        return false;
+    }
+
+    bool intersects(const VarSet& other) const {
+        auto a = words.begin(), b = other.words.begin();
+        while (a != words.end() && b != other.words.end()) {
+            if (a->first < b->first) ++a;
+            else if (b->first < a->first) ++b;
+            else if (a++->second & b++->second) return true;
+        }
+        return false;
+    }
+
+    /// Вызывает f(id) для каждого элемента по возрастанию.
+    template <typename F>
+    void forEach(F f) const {
+        for (const auto& [index, bits] : words) {
+            for (std::uint64_t w = bits; w; w &= w - 1) {
+                f(static_cast<std::uint32_t>(index * 64 + __builtin_ctzll(w)));
+            }
+        }
+    }
+};
+
+/// Чтения и записи одного оператора.
+struct StatementEffects {
+    VarSet reads;  ///< Переменные условия и правой части присваивания.
+    VarSet writes; ///< Присваиваемая переменная.
+};
+
+/// Пул потоков, выполняющий параллельный цикл по диапазону индексов.
+class ThreadPool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    std::function<void(size_t, size_t)> task;
+    size_t total = 0, chunk = 1;
+    std::atomic<size_t> next{0};
+    size_t busy = 0;
+    std::uint64_t generation = 0;
+    bool stopping = false;
+
+    void loop() {
+        std::uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            size_t begin;
+            while ((begin = next.fetch_add(chunk)) < total) task(begin, std::min(total, begin + chunk));
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0) done.notify_one();
+        }
+    }
+
+public:
+    /// Создаёт пул из threads потоков (включая вызывающий).
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()) {
+        for (size_t i = 1; i < std::max<size_t>(threads, 1); ++i) workers.emplace_back([this] { loop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    size_t size() const { return workers.size() + 1; }
+
+    /// Выполняет f(begin, end) по кускам размера не меньше grain для [0, n) и ждёт окончания.
+    void parallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t)>& f) {
+        if (workers.empty() || n <= grain) {
+            if (n) f(0, n);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = f;
+            total = n;
+            chunk = std::max(grain, n / (4 * size()) + 1);
+            next = 0;
+            busy = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        size_t begin;
+        while ((begin = next.fetch_add(chunk)) < total) task(begin, std::min(total, begin + chunk));
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return busy == 0; });
+    }
+};
+
+/// Программа, разбитая на группы независимых операторов.
+///
+/// Для каждого цикла вычисляются множества чтений и записей; оператор j
+/// зависит от более раннего i, если j читает или пишет то, что пишет i,
+/// или пишет то, что i читает. По этим рёбрам строится DAG, и операторы
+/// раскладываются по уровням (длина самого длинного пути от истока): внутри
+/// уровня операторы независимы и выполняются на пуле потоков одновременно,
+/// уровни — по порядку. Так сохраняется результат последовательного выполнения.
+/// Каждый цикл исполняется в замкнутой форме (см. TripCount), поэтому не крутится.
+class ParallelProgram {
+    /// Цикл в замкнутой форме.
+    struct Step {
+        bool lhsVar, rhsVar, valueVar;
+        std::int64_t lhs, rhs, value;
+        char rel;
+        std::uint32_t target;
+
+        bool holds(const std::int64_t* env) const {
+            std::int64_t l = lhsVar ? env[lhs] : lhs, r = rhsVar ? env[rhs] : rhs;
+            return rel == '<' ? l < r : rel == '>' ? l > r : l == r;
+        }
+
+        /// Выполняет цикл; false — цикл бесконечен.
+        bool run(std::int64_t* env) const {
+            if (!holds(env)) return true;
+            env[target] = valueVar ? env[value] : value;
+            return !holds(env);
+        }
+    };
+
+    VarTable table;
+    std::vector<Step> steps;
+    std::vector<StatementEffects> effects;
+    std::vector<std::vector<std::uint32_t>> successors;
+    std::vector<std::vector<std::uint32_t>> levels;
+
+    void addEdge(std::uint32_t from, std::uint32_t to) {
+        if (from != to) successors[from].push_back(to);
+    }
+
+public:
+    /// Строит шаги, множества эффектов, DAG зависимостей и уровни.
+    static ParallelProgram compile(const std::shared_ptr<ASTNode>& program) {
+        ParallelProgram p;
+        const auto& loops = program->children[0]->children;
+        for (const auto& loop : loops) {
+            const auto& cond = loop->children[0];
+            const auto& body = loop->children[1];
+            StatementEffects fx;
+            auto operand = [&](const std::shared_ptr<ASTNode>& node, bool& variable, std::int64_t& value) {
+                variable = node->type != "RomanNumeral";
+                value = variable ? p.table.intern(node->value) : romanToInt(node->value);
+                if (variable) fx.reads.insert(static_cast<std::uint32_t>(value));
+            };
+            Step step;
+            operand(cond->children[0], step.lhsVar, step.lhs);
+            operand(cond->children[2], step.rhsVar, step.rhs);
+            step.rel = cond->children[1]->value[0];
+            step.target = p.table.intern(body->children[0]->value);
+            fx.writes.insert(step.target);
+            operand(body->children[1], step.valueVar, step.value);
+            p.steps.push_back(step);
+            p.effects.push_back(std::move(fx));
+        }
+
+        // Рёбра через последнего писателя и читателей после него: O(число вхождений).
+        const std::uint32_t none = UINT32_MAX;
+        std::vector<std::uint32_t> lastWriter(p.table.size(), none);
+        std::vector<std::vector<std::uint32_t>> readersSince(p.table.size());
+        p.successors.resize(p.steps.size());
+        std::vector<std::uint32_t> level(p.steps.size(), 0);
+        for (std::uint32_t i = 0; i < p.steps.size(); ++i) {
+            std::vector<std::uint32_t> preds;
+            p.effects[i].reads.forEach([&](std::uint32_t v) {
+                if (lastWriter[v] != none) preds.push_back(lastWriter[v]);
+            });
+            p.effects[i].writes.forEach([&](std::uint32_t v) {
+                if (lastWriter[v] != none) preds.push_back(lastWriter[v]);
+                for (std::uint32_t r : readersSince[v]) preds.push_back(r);
+            });
+            std::sort(preds.begin(), preds.end());
+            preds.erase(std::unique(preds.begin(), preds.end()), preds.end());
+            for (std::uint32_t from : preds) {
+                p.addEdge(from, i);
+                if (from != i) level[i] = std::max(level[i], level[from] + 1);
+            }
+
+            p.effects[i].reads.forEach([&](std::uint32_t v) { readersSince[v].push_back(i); });
+            p.effects[i].writes.forEach([&](std::uint32_t v) {
+                lastWriter[v] = i;
+                readersSince[v].clear();
+            });
+            if (level[i] >= p.levels.size()) p.levels.resize(level[i] + 1);
+            p.levels[level[i]].push_back(i);
+        }
+        return p;
+    }
+
+    const VarTable& vars() const { return table; }
+    const StatementEffects& effectsOf(size_t statement) const { return effects[statement]; }
+    const std::vector<std::uint32_t>& dependents(size_t statement) const { return successors[statement]; }
+    size_t depth() const { return levels.size(); }
+
+    /// Можно ли выполнять операторы a и b одновременно.
+    bool independent(size_t a, size_t b) const {
+        const auto& x = effects[a];
+        const auto& y = effects[b];
+        return !x.writes.intersects(y.writes) && !x.writes.intersects(y.reads) && !x.reads.intersects(y.writes);
+    }
+
+    /// Выполняет программу над env на пуле потоков. Возвращает false, если
+    /// какой-либо цикл бесконечен (тогда значения env не определены).
+    bool run(std::vector<std::int64_t>& env, ThreadPool& pool, size_t grain = 4096) const {
+        if (env.size() < table.size()) env.resize(table.size(), 0);
+        std::int64_t* vars = env.data();
+        std::atomic<bool> diverged{false};
+        for (const auto& group : levels) {
+            pool.parallelFor(group.size(), grain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    if (!steps[group[i]].run(vars)) diverged.store(true, std::memory_order_relaxed);
+                }
+            });
+            if (diverged) return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,56 @@
+#include "symindex.hpp"
+
+#include <chrono>
+#include <sstream>
+
+/// Утилита индекса переменных:
+///   symindex.exe build <индекс> <файл>...    — проиндексировать программы;
+///   symindex.exe query <индекс> <имя> [use]  — где переменной присваивают (или где её читают).
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "";
+
+    if (mode == "build" && argc > 3)
+    {
+        SymbolIndexBuilder builder;
+        for (int i = 3; i < argc; ++i)
+        {
+            std::ifstream in(argv[i]);
+            std::stringstream source;
+            source << in.rdbuf();
+            if (!in || !builder.addFile(argv[i], source.str()))
+            {
+                std::cerr << "Пропущен файл: " << argv[i] << "\n";
+            }
+        }
+        if (!builder.write(argv[2]))
+        {
+            std::cerr << "Не удалось записать индекс " << argv[2] << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (mode == "query" && argc > 3)
+    {
+        auto start = std::chrono::steady_clock::now();
+        SymbolIndex index;
+        if (!index.open(argv[2]))
+        {
+            std::cerr << "Не удалось открыть индекс " << argv[2] << "\n";
+            return 1;
+        }
+
+        SymbolRole role = argc > 4 && std::string(argv[4]) == "use" ? SymbolRole::Used : SymbolRole::Assigned;
+        std::size_t found = index.find(argv[3], role, [&](const Occurrence &occ)
+                                       { std::cout << index.fileName(occ.file) << ": цикл " << occ.statement
+                                                   << ", токен " << occ.offset << "\n"; });
+
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << "Найдено вхождений: " << found << " за " << elapsed << " мс\n";
+        return 0;
+    }
+
+    std::cerr << "Использование: " << argv[0] << " build <индекс> <файл>... | query <индекс> <имя> [use]\n";
+    return 1;
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include "main.hpp"
+#include "varint.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Роль вхождения переменной в программе.
+enum class SymbolRole { Assigned = 0, Used = 1 }; ///< LValue или Identifier.
+
+/// Одно вхождение переменной.
+struct Occurrence {
+    std::uint32_t file;      ///< Номер файла в индексе.
+    std::uint32_t statement; ///< Номер цикла в файле (с нуля).
+    std::uint32_t offset;    ///< Номер токена в потоке токенов файла (с нуля; не байт и не узел AST).
+};
+
+/// Формат файла индекса (числа — в порядке байтов машины, записавшей индекс;
+/// на машине с другим порядком не совпадёт версия, и open() откажет):
+///   заголовок SymbolIndexHeader;
+///   таблица файлов: fileCount записей IndexFileEntry;
+///   таблица термов: termCount записей IndexTermEntry, отсортированных по имени;
+///   пул строк (имена файлов и переменных без завершающих нулей);
+///   списки вхождений: тройки (файл, цикл, смещение), закодированные varint
+///   с дельтами относительно предыдущего вхождения того же файла.
+/// Таблицы имеют фиксированный размер записей, поэтому поиск терма выполняется
+/// бинарным поиском прямо по отображённому в память файлу.
+struct SymbolIndexHeader {
+    char magic[4];            ///< "WLSI".
+    std::uint32_t version;    ///< Версия формата.
+    std::uint32_t fileCount;  ///< Число проиндексированных файлов.
+    std::uint32_t termCount;  ///< Число различных переменных.
+    std::uint64_t files;      ///< Смещение таблицы файлов.
+    std::uint64_t terms;      ///< Смещение таблицы термов.
+    std::uint64_t strings;    ///< Смещение пула строк.
+    std::uint64_t postings;   ///< Смещение списков вхождений.
+};
+
+/// Запись таблицы файлов.
+struct IndexFileEntry {
+    std::uint64_t name;       ///< Смещение имени в пуле строк.
+    std::uint32_t length;     ///< Длина имени.
+    std::uint32_t reserved;
+};
+
+/// Запись таблицы термов.
+struct IndexTermEntry {
+    std::uint64_t name;       ///< Смещение имени в пуле строк.
+    std::uint32_t length;     ///< Длина имени.
+    std::uint32_t count[2];   ///< Число вхождений по ролям (SymbolRole).
+    std::uint32_t reserved;
+    std::uint64_t list[2];    ///< Смещения списков вхождений от начала раздела postings.
+};
+
+/// Построитель индекса: собирает вхождения переменных по набору программ
+/// и записывает их в файл.
+class SymbolIndexBuilder {
+    std::vector<std::string> files;
+    std::unordered_map<std::string, std::array<std::vector<Occurrence>, 2>> postings;
+
+public:
+    /// Индексирует одну программу. Переменная слева от ':=' считается
+    /// присваиванием (LValue), остальные вхождения — использованием.
+    /// Возвращает false, если лексический анализ не удался.
+    bool addFile(const std::string& name, const std::string& source) {
+        auto tokens = tokenize(source);
+        if (tokens.empty()) return false;
+
+        auto file = static_cast<std::uint32_t>(files.size());
+        files.push_back(name);
+        std::uint32_t statement = 0;
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            if (tokens[i].type == TokenType::SEMICOLON) {
+                statement++;
+            } else if (tokens[i].type == TokenType::IDENTIFIER) {
+                bool assigned = i + 1 < tokens.size() && tokens[i + 1].type == TokenType::ASSIGN;
+                auto role = assigned ? SymbolRole::Assigned : SymbolRole::Used;
+                postings[tokens[i].value][static_cast<int>(role)].push_back(
+                    {file, statement, static_cast<std::uint32_t>(i)});
+            }
+        }
+        return true;
+    }
+
+    /// Записывает индекс в файл path.
+    bool write(const std::string& path) const {
+        std::vector<const std::string*> names;
+        for (const auto& entry : postings) names.push_back(&entry.first);
+        std::sort(names.begin(), names.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+
+        std::string strings, lists;
+        std::vector<IndexFileEntry> fileTable;
+        for (const auto& name : files) {
+            fileTable.push_back({strings.size(), static_cast<std::uint32_t>(name.size()), 0});
+            strings += name;
+        }
+
+        std::vector<IndexTermEntry> termTable;
+        for (const std::string* name : names) {
+            IndexTermEntry term{strings.size(), static_cast<std::uint32_t>(name->size()), {0, 0}, 0, {0, 0}};
+            strings += *name;
+            const auto& byRole = postings.at(*name);
+            for (int role = 0; role < 2; ++role) {
+                term.count[role] = static_cast<std::uint32_t>(byRole[role].size());
+                term.list[role] = lists.size();
+                Occurrence prev{0, 0, 0};
+                for (const auto& occ : byRole[role]) {
+                    bool sameFile = occ.file == prev.file;
+                    putVarint(lists, occ.file - prev.file);
+                    putVarint(lists, sameFile ? occ.statement - prev.statement : occ.statement);
+                    putVarint(lists, sameFile ? occ.offset - prev.offset : occ.offset);
+                    prev = occ;
+                }
+            }
+            termTable.push_back(term);
+        }
+
+        SymbolIndexHeader header{{'W', 'L', 'S', 'I'}, 1,
+                                 static_cast<std::uint32_t>(fileTable.size()),
+                                 static_cast<std::uint32_t>(termTable.size()), 0, 0, 0, 0};
+        header.files = sizeof(header);
+        header.terms = header.files + fileTable.size() * sizeof(IndexFileEntry);
+        header.strings = header.terms + termTable.size() * sizeof(IndexTermEntry);
+        header.postings = header.strings + strings.size();
+
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(fileTable.data()), fileTable.size() * sizeof(IndexFileEntry));
+        out.write(reinterpret_cast<const char*>(termTable.data()), termTable.size() * sizeof(IndexTermEntry));
+        out.write(strings.data(), strings.size());
+        out.write(lists.data(), lists.size());
+        return static_cast<bool>(out);
+    }
+};
+
+/// Индекс, открытый только для чтения через mmap. Запросы не копируют данные
+/// и не читают ничего, кроме таблицы термов и нужного списка вхождений.
+class SymbolIndex {
+    const unsigned char* data = nullptr;
+    std::size_t size = 0;
+    const SymbolIndexHeader* header = nullptr;
+
+    const IndexTermEntry* terms() const {
+        return reinterpret_cast<const IndexTermEntry*>(data + header->terms);
+    }
+
+    std::string_view str(std::uint64_t offset, std::uint32_t length) const {
+        return {reinterpret_cast<const char*>(data + header->strings + offset), length};
+    }
+
+    /// Проверяет, что все разделы и ссылки из записей лежат внутри файла,
+    /// чтобы запросы к усечённому или испорченному индексу не читали за его концом.
+    bool valid() const {
+        const SymbolIndexHeader& h = *header;
+        if (std::memcmp(h.magic, "WLSI", 4) != 0 || h.version != 1) return false;
+        if (h.files != sizeof(SymbolIndexHeader) || h.terms < h.files || h.strings < h.terms ||
+            h.postings < h.strings || h.postings > size)
+            return false;
+        if ((h.terms - h.files) / sizeof(IndexFileEntry) != h.fileCount ||
+            (h.terms - h.files) % sizeof(IndexFileEntry) != 0 ||
+            (h.strings - h.terms) / sizeof(IndexTermEntry) != h.termCount ||
+            (h.strings - h.terms) % sizeof(IndexTermEntry) != 0)
+            return false;
+
+        std::uint64_t pool = h.postings - h.strings;
+        std::uint64_t lists = size - h.postings;
+        auto inPool = [&](std::uint64_t offset, std::uint32_t length) { return offset <= pool && length <= pool - offset; };
+        const auto* fileTable = reinterpret_cast<const IndexFileEntry*>(data + h.files);
+        for (std::uint32_t i = 0; i < h.fileCount; ++i)
+            if (!inPool(fileTable[i].name, fileTable[i].length)) return false;
+        for (std::uint32_t i = 0; i < h.termCount; ++i) {
+            const IndexTermEntry& term = terms()[i];
+            if (!inPool(term.name, term.length)) return false;
+            // Каждое вхождение занимает не меньше трёх байтов (три varint)
+            for (int r = 0; r < 2; ++r)
+                if (term.list[r] > lists || term.count[r] > (lists - term.list[r]) / 3) return false;
+        }
+        return true;
+    }
+
+public:
+    SymbolIndex() = default;
+    SymbolIndex(const SymbolIndex&) = delete;
+    SymbolIndex& operator=(const SymbolIndex&) = delete;
+    ~SymbolIndex() { close(); }
+
+    /// Закрывает открытый индекс (если есть).
+    void close() {
+        if (data) munmap(const_cast<unsigned char*>(data), size);
+        data = nullptr;
+        header = nullptr;
+        size = 0;
+    }
+
+    /// Отображает файл индекса в память (закрыв ранее открытый); возвращает
+    /// false, если файл не открывается или его разделы выходят за его размер.
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(SymbolIndexHeader)) {
+            ::close(fd);
+            return false;
+        }
+        size = static_cast<std::size_t>(st.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            size = 0;
+            return false;
+        }
+
+        data = static_cast<const unsigned char*>(mapped);
+        header = reinterpret_cast<const SymbolIndexHeader*>(data);
+        if (!valid()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /// Число файлов в индексе.
+    std::uint32_t files() const { return header ? header->fileCount : 0; }
+
+    /// Имя файла по его номеру (пустое для номера вне индекса).
+    std::string_view fileName(std::uint32_t file) const {
+        if (file >= files()) return {};
+        const auto* entry = reinterpret_cast<const IndexFileEntry*>(data + header->files) + file;
+        return str(entry->name, entry->length);
+    }
+
+    /// Вызывает callback для каждого вхождения переменной name с ролью role;
+    /// возвращает число вхождений (0, если переменная не встречается).
+    std::size_t find(std::string_view name, SymbolRole role,
+                     const std::function<void(const Occurrence&)>& callback) const {
+        if (!header) return 0;
+        const IndexTermEntry* begin = terms();
+        const IndexTermEntry* end = begin + header->termCount;
+        const IndexTermEntry* term = std::lower_bound(begin, end, name, [&](const IndexTermEntry& e, std::string_view key) {
+            return str(e.name, e.length) < key;
+        });
+        if (term == end || str(term->name, term->length) != name) return 0;
+
+        int r = static_cast<int>(role);
+        const unsigned char* p = data + header->postings + term->list[r];
+        const unsigned char* stop = data + size;
+        Occurrence occ{0, 0, 0};
+        for (std::uint32_t i = 0; i < term->count[r]; ++i) {
+            std::uint64_t fileDelta, statement, offset;
+            if (!getVarint(p, stop, fileDelta) || !getVarint(p, stop, statement) || !getVarint(p, stop, offset))
+                return i; // Список испорчен: отдаём только прочитанные вхождения
+            if (fileDelta == 0) {
+                occ.statement += static_cast<std::uint32_t>(statement);
+                occ.offset += static_cast<std::uint32_t>(offset);
+            } else {
+                occ.file += static_cast<std::uint32_t>(fileDelta);
+                occ.statement = static_cast<std::uint32_t>(statement);
+                occ.offset = static_cast<std::uint32_t>(offset);
+            }
+            callback(occ);
+        }
+        return term->count[r];
+    }
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "main.hpp"
+#include "varint.hpp"
+
+/// Сжатый формат хранения потока токенов.
+///
+/// Поток начинается с сигнатуры "WLTS" и состоит из групп: байт с двумя
+/// 4-битными кодами TokenType (сначала младшая тетрада, код 15 — заполнитель),
+/// за которым идут varint-данные токенов этой группы в том же порядке:
+///   IDENTIFIER    — номер в словаре; новый номер (равный размеру словаря)
+///                   сопровождается длиной и байтами имени;
+///   ROMAN_NUMERAL — значение << 1 для канонической записи числа,
+///                   иначе (номер в словаре << 1) | 1 как у идентификатора;
+///   остальные     — без данных, значение определяется типом.
+/// Поток заканчивается токеном END, поэтому декодер не знает заранее его длины
+/// и может выдавать токены синтаксическому анализатору по одному.
+class TokenStreamEncoder {
+public:
+    /// Наибольшее римское число, записываемое значением; длинные записи
+    /// (до value / 10 символов X) идут через словарь, как неканонические.
+    static constexpr int MaxRomanValue = 1 << 16;
+
+private:
+    std::string out;
+    std::unordered_map<std::string, std::uint64_t> dictionary;
+    int pending = -1; ///< Позиция байта типов, у которого занята только младшая тетрада.
+
+    /// Записывает номер строки в словаре (с телом строки, если она новая).
+    void putString(const std::string& s, std::uint64_t tag, int shift) {
+        auto it = dictionary.find(s);
+        if (it != dictionary.end()) {
+            putVarint(out, (it->second << shift) | tag);
+            return;
+        }
+        std::uint64_t id = dictionary.size();
+        dictionary.emplace(s, id);
+        putVarint(out, (id << shift) | tag);
+        putVarint(out, s.size());
+        out += s;
+    }
+
+public:
+    TokenStreamEncoder() : out("WLTS") {}
+
+    /// Добавляет один токен в поток.
+    void put(const Token& token) {
+        auto code = static_cast<unsigned char>(token.type);
+        if (pending < 0) {
+            pending = static_cast<int>(out.size());
+            out.push_back(static_cast<char>(0xF0 | code));
+        } else {
+            out[pending] = static_cast<char>((static_cast<unsigned char>(out[pending]) & 0x0F) | (code << 4));
+            pending = -1;
+        }
+
+        if (token.type == TokenType::IDENTIFIER) {
+            putString(token.value, 0, 0);
+        } else if (token.type == TokenType::ROMAN_NUMERAL) {
+            int value = romanToInt(token.value);
+            if (value <= MaxRomanValue && intToRoman(value) == token.value) {
+                putVarint(out, static_cast<std::uint64_t>(value) << 1);
+            } else {
+                putString(token.value, 1, 1);
+            }
+        }
+    }
+
+    /// Кодирует весь список токенов (он должен заканчиваться END).
+    static std::string encode(const std::vector<Token>& tokens) {
+        TokenStreamEncoder encoder;
+        for (const auto& token : tokens) encoder.put(token);
+        return encoder.finish();
+    }
+
+    /// Возвращает закодированный поток.
+    std::string finish() { return std::move(out); }
+};
+
+/// Потоковый декодер: читает сжатый поток и отдаёт токены по одному,
+/// поэтому может напрямую служить источником для LRParser. Каждое чтение
+/// ограничено концом буфера; на усечённом или испорченном потоке декодер
+/// выдаёт END (разбор сообщит о синтаксической ошибке), а причина доступна
+/// через error().
+class TokenStreamDecoder : public TokenSource {
+    const unsigned char* p;
+    const unsigned char* end;
+    std::vector<std::string> dictionary;
+    unsigned char group = 0xFF; ///< Необработанные тетрады текущего байта типов.
+    bool finished = false;
+    std::string failure;
+
+    Token fail(const char* message) {
+        failure = message;
+        finished = true;
+        group = 0xFF;
+        return Token(TokenType::END, "");
+    }
+
+    /// Строка словаря с номером id; новая строка (id == размер словаря) читается из потока.
+    bool getString(std::uint64_t id, std::string& out) {
+        if (id < dictionary.size()) {
+            out = dictionary[id];
+            return true;
+        }
+        std::uint64_t length;
+        if (id != dictionary.size() || !getVarint(p, end, length) || length > static_cast<std::uint64_t>(end - p))
+            return false;
+        dictionary.emplace_back(reinterpret_cast<const char*>(p), length);
+        p += length;
+        out = dictionary.back();
+        return true;
+    }
+
+public:
+    /// Декодер над буфером; буфер должен существовать, пока читаются токены.
+    TokenStreamDecoder(const std::string& data)
+        : p(reinterpret_cast<const unsigned char*>(data.data())), end(p + data.size()) {
+        if (data.size() < 4 || data.compare(0, 4, "WLTS") != 0) fail("неверная сигнатура потока токенов");
+        else p += 4;
+    }
+
+    /// Причина преждевременного конца потока (пусто, если поток корректен).
+    const std::string& error() const { return failure; }
+
+    Token next() override {
+        if ((group & 0x0F) == 0x0F) {
+            if (finished) return Token(TokenType::END, "");
+            if (p >= end) return fail("поток оборвался до токена END");
+            group = *p++;
+        }
+        auto type = static_cast<TokenType>(group & 0x0F);
+        group = static_cast<unsigned char>(group >> 4 | 0xF0);
+
+        std::uint64_t v;
+        std::string value;
+        switch (type) {
+        case TokenType::WHILE: return Token(type, "while");
+        case TokenType::DONE: return Token(type, "done");
+        case TokenType::SEMICOLON: return Token(type, ";");
+        case TokenType::LPAREN: return Token(type, "(");
+        case TokenType::RPAREN: return Token(type, ")");
+        case TokenType::ASSIGN: return Token(type, ":=");
+        case TokenType::LESS: return Token(type, "<");
+        case TokenType::GREATER: return Token(type, ">");
+        case TokenType::EQUAL: return Token(type, "=");
+        case TokenType::IDENTIFIER:
+            if (!getVarint(p, end, v) || !getString(v, value)) return fail("испорчен идентификатор");
+            return Token(type, std::move(value));
+        case TokenType::ROMAN_NUMERAL:
+            if (!getVarint(p, end, v)) return fail("испорчено римское число");
+            if (v & 1) {
+                if (!getString(v >> 1, value)) return fail("испорчено римское число");
+                return Token(type, std::move(value));
+            }
+            if (v >> 1 == 0 || v >> 1 > TokenStreamEncoder::MaxRomanValue) return fail("римское число вне диапазона");
+            return Token(type, intToRoman(static_cast<int>(v >> 1)));
+        case TokenType::END:
+            finished = true;
+            group = 0xFF;
+            return Token(TokenType::END, "");
+        }
+        return fail("неизвестный код токена");
+    }
+};
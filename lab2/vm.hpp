@@ -0,0 +1,249 @@
+#pragma once
+
+#include "main.hpp"
+#include "loopanalysis.hpp"
+
+/// Таблица переменных программы: имя -> номер ячейки в окружении.
+class VarTable {
+    std::unordered_map<std::string, std::uint32_t> ids;
+    std::vector<std::string> names;
+
+public:
+    /// Возвращает номер переменной, заводя новую ячейку при первом обращении.
+    std::uint32_t intern(const std::string& name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        auto id = static_cast<std::uint32_t>(names.size());
+        ids.emplace(name, id);
+        names.push_back(name);
+        return id;
+    }
+
+    /// Номер переменной или -1, если её нет в программе.
+    long find(const std::string& name) const {
+        auto it = ids.find(name);
+        return it == ids.end() ? -1 : static_cast<long>(it->second);
+    }
+
+    const std::string& name(std::uint32_t id) const { return names[id]; }
+    std::size_t size() const { return names.size(); }
+};
+
+/// Команды виртуальной машины.
+enum class Op : std::uint8_t {
+    // Обычный байткод: одна команда на узел AST, стековая машина.
+    PushVar,      ///< Положить на стек переменную a.
+    PushConst,    ///< Положить на стек константу b.
+    Less,         ///< Сравнить два верхних значения стека.
+    Greater,
+    Equal,
+    JumpIfFalse,  ///< Снять значение; если оно ложно — перейти на target.
+    Store,        ///< Снять значение и записать в переменную a.
+    Jump,         ///< Безусловный переход на target (обратная дуга цикла).
+    Halt,         ///< Конец программы.
+
+    // Суперкоманды для типовых форм цикла; отношение зашито в код операции.
+    ExitUnlessVarLessConst,    ///< Если не (a < b) — выйти из цикла на target.
+    ExitUnlessVarGreaterConst,
+    ExitUnlessVarEqualConst,
+    ExitUnlessVarLessVar,      ///< Если не (a < var[b]) — выйти из цикла на target.
+    ExitUnlessVarGreaterVar,
+    ExitUnlessVarEqualVar,
+    AssignConstLoop,           ///< a := b и переход к заголовку цикла target.
+    AssignVarLoop,             ///< a := var[b] и переход к заголовку цикла target.
+
+    // Замкнутая форма циклов (см. TripCount): прямолинейный код без обратных дуг.
+    AssignConst,               ///< a := b.
+    AssignVar,                 ///< a := var[b].
+    Diverge,                   ///< Программа зацикливается: выполнение прекращается.
+};
+
+/// Одна команда: код операции и операнды.
+struct Instr {
+    Op op;
+    std::uint32_t a = 0;      ///< Номер переменной.
+    std::int64_t b = 0;       ///< Константа или номер второй переменной.
+    std::uint32_t target = 0; ///< Адрес перехода.
+};
+
+/// Способ компиляции AST в байткод.
+enum class CompileMode {
+    Plain, ///< Одна команда на узел.
+    Super, ///< Суперкоманды: сравнение с переходом, присваивание с обратной дугой.
+    Closed, ///< Циклы заменены прямолинейным кодом по TripCount: выполнение никогда не крутится.
+};
+
+/// Скомпилированная программа.
+struct Bytecode {
+    std::vector<Instr> code;
+    VarTable vars;
+};
+
+/// Компилятор AST программы в байткод.
+class Compiler {
+    Bytecode out;
+
+    /// Операнд выражения: переменная (номер) или значение римского числа.
+    struct Operand {
+        bool variable;
+        std::int64_t value;
+    };
+
+    Operand operand(const std::shared_ptr<ASTNode>& node) {
+        if (node->type == "RomanNumeral") return {false, romanToInt(node->value)};
+        return {true, out.vars.intern(node->value)};
+    }
+
+    void emit(Op op, std::uint32_t a = 0, std::int64_t b = 0, std::uint32_t target = 0) {
+        out.code.push_back({op, a, b, target});
+    }
+
+    std::uint32_t here() const { return static_cast<std::uint32_t>(out.code.size()); }
+
+    void push(const Operand& op) {
+        if (op.variable) emit(Op::PushVar, static_cast<std::uint32_t>(op.value));
+        else emit(Op::PushConst, 0, op.value);
+    }
+
+    void compilePlain(Operand lhs, char rel, Operand rhs, std::uint32_t target, Operand value) {
+        std::uint32_t head = here();
+        push(lhs);
+        push(rhs);
+        emit(rel == '<' ? Op::Less : rel == '>' ? Op::Greater : Op::Equal);
+        std::uint32_t exitJump = here();
+        emit(Op::JumpIfFalse);
+        push(value);
+        emit(Op::Store, target);
+        emit(Op::Jump, 0, 0, head);
+        out.code[exitJump].target = here();
+    }
+
+    /// Выдаёт переход на (пока неизвестный) адрес, если условие ложно;
+    /// возвращает номер команды для последующей правки адреса.
+    std::uint32_t emitExitUnless(Operand lhs, char rel, Operand rhs) {
+        if (!lhs.variable) {
+            // c < v равносильно v > c: переменная всегда слева.
+            std::swap(lhs, rhs);
+            rel = rel == '<' ? '>' : rel == '>' ? '<' : rel;
+        }
+        static const Op withConst[] = {Op::ExitUnlessVarLessConst, Op::ExitUnlessVarGreaterConst, Op::ExitUnlessVarEqualConst};
+        static const Op withVar[] = {Op::ExitUnlessVarLessVar, Op::ExitUnlessVarGreaterVar, Op::ExitUnlessVarEqualVar};
+        int relIndex = rel == '<' ? 0 : rel == '>' ? 1 : 2;
+
+        std::uint32_t at = here();
+        emit(rhs.variable ? withVar[relIndex] : withConst[relIndex], static_cast<std::uint32_t>(lhs.value), rhs.value);
+        return at;
+    }
+
+    void compileSuper(Operand lhs, char rel, Operand rhs, std::uint32_t target, Operand value) {
+        if (!lhs.variable && !rhs.variable) {
+            // Условие из констант: цикл либо не выполняется, либо бесконечен.
+            bool holds = rel == '<' ? lhs.value < rhs.value : rel == '>' ? lhs.value > rhs.value : lhs.value == rhs.value;
+            if (!holds) return;
+            std::uint32_t self = here();
+            emit(value.variable ? Op::AssignVarLoop : Op::AssignConstLoop, target, value.value, self);
+            return;
+        }
+        std::uint32_t head = emitExitUnless(lhs, rel, rhs);
+        emit(value.variable ? Op::AssignVarLoop : Op::AssignConstLoop, target, value.value, head);
+        out.code[head].target = here();
+    }
+
+    /// Цикл как прямолинейный код: if (c) { x := e; if (c) зацикливание; },
+    /// где ненужные по TripCount части опущены.
+    void compileClosed(Operand lhs, char rel, Operand rhs, std::uint32_t target, Operand value, TripCount trips) {
+        if (trips == TripCount::Zero) return;
+        if (trips == TripCount::Infinite) {
+            emit(Op::Diverge);
+            return;
+        }
+        std::uint32_t skip = emitExitUnless(lhs, rel, rhs), recheck = skip;
+        if (trips != TripCount::ZeroOrInfinite) {
+            emit(value.variable ? Op::AssignVar : Op::AssignConst, target, value.value);
+        }
+        if (trips != TripCount::ZeroOrOne) {
+            if (trips == TripCount::ZeroOneOrInfinite) recheck = emitExitUnless(lhs, rel, rhs);
+            emit(Op::Diverge);
+        }
+        out.code[skip].target = out.code[recheck].target = here();
+    }
+
+public:
+    /// Компилирует AST программы (корень Program) в байткод.
+    static Bytecode compile(const std::shared_ptr<ASTNode>& program, CompileMode mode = CompileMode::Super) {
+        Compiler c;
+        for (const auto& loop : program->children[0]->children) {
+            const auto& cond = loop->children[0];
+            const auto& body = loop->children[1];
+            Operand lhs = c.operand(cond->children[0]);
+            char rel = cond->children[1]->value[0];
+            Operand rhs = c.operand(cond->children[2]);
+            std::uint32_t target = c.out.vars.intern(body->children[0]->value);
+            Operand value = c.operand(body->children[1]);
+            if (mode == CompileMode::Plain) c.compilePlain(lhs, rel, rhs, target, value);
+            else if (mode == CompileMode::Super) c.compileSuper(lhs, rel, rhs, target, value);
+            else c.compileClosed(lhs, rel, rhs, target, value, classifyLoop(loop));
+        }
+        c.emit(Op::Halt);
+        return std::move(c.out);
+    }
+};
+
+/// Итог выполнения программы.
+struct ExecResult {
+    bool finished;            ///< false — исчерпан лимит команд или обнаружено зацикливание.
+    std::uint64_t dispatches; ///< Сколько команд было выполнено.
+    bool diverged = false;    ///< Программа гарантированно не завершается (команда Diverge).
+};
+
+/// Интерпретатор байткода. env — значения переменных по номерам из VarTable
+/// (недостающие ячейки дополняются нулями); fuel — лимит выполненных команд.
+ExecResult execute(const Bytecode& program, std::vector<std::int64_t>& env, std::uint64_t fuel = UINT64_MAX) {
+    if (env.size() < program.vars.size()) env.resize(program.vars.size(), 0);
+    std::int64_t* vars = env.data();
+    const Instr* code = program.code.data();
+    std::vector<std::int64_t> stack(4);
+    std::int64_t* sp = stack.data();
+    std::uint64_t dispatches = 0;
+    std::uint32_t pc = 0;
+
+    for (;;) {
+        const Instr& in = code[pc];
+        dispatches++;
+        switch (in.op) {
+        case Op::PushVar: *sp++ = vars[in.a]; pc++; break;
+        case Op::PushConst: *sp++ = in.b; pc++; break;
+        case Op::Less: sp--; sp[-1] = sp[-1] < sp[0]; pc++; break;
+        case Op::Greater: sp--; sp[-1] = sp[-1] > sp[0]; pc++; break;
+        case Op::Equal: sp--; sp[-1] = sp[-1] == sp[0]; pc++; break;
+        case Op::JumpIfFalse: pc = *--sp ? pc + 1 : in.target; break;
+        case Op::Store: vars[in.a] = *--sp; pc++; break;
+        case Op::Jump:
+            if (dispatches >= fuel) return {false, dispatches};
+            pc = in.target;
+            break;
+        case Op::Halt: return {true, dispatches};
+
+        case Op::ExitUnlessVarLessConst: pc = vars[in.a] < in.b ? pc + 1 : in.target; break;
+        case Op::ExitUnlessVarGreaterConst: pc = vars[in.a] > in.b ? pc + 1 : in.target; break;
+        case Op::ExitUnlessVarEqualConst: pc = vars[in.a] == in.b ? pc + 1 : in.target; break;
+        case Op::ExitUnlessVarLessVar: pc = vars[in.a] < vars[in.b] ? pc + 1 : in.target; break;
+        case Op::ExitUnlessVarGreaterVar: pc = vars[in.a] > vars[in.b] ? pc + 1 : in.target; break;
+        case Op::ExitUnlessVarEqualVar: pc = vars[in.a] == vars[in.b] ? pc + 1 : in.target; break;
+        case Op::AssignConstLoop:
+            vars[in.a] = in.b;
+            if (dispatches >= fuel) return {false, dispatches};
+            pc = in.target;
+            break;
+        case Op::AssignVarLoop:
+            vars[in.a] = vars[in.b];
+            if (dispatches >= fuel) return {false, dispatches};
+            pc = in.target;
+            break;
+
+        case Op::AssignConst: vars[in.a] = in.b; pc++; break;
+        case Op::AssignVar: vars[in.a] = vars[in.b]; pc++; break;
+        case Op::Diverge: return {false, dispatches, true};
+        }
+    }
+}